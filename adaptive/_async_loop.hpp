@@ -0,0 +1,104 @@
+#pragma once
+
+#ifndef _ASYNC_LOOP_HPP_
+#define _ASYNC_LOOP_HPP_
+
+#include "_parallel_for_worker.hpp"
+#include "_thread_handler.hpp"
+#include "task_arena.hpp"
+
+#include <new>
+#include <utility>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: AsyncLoopInterface
+ * --------------------------
+ *   Loop launched by parallel_for_async, or detached by the senders of execution.hpp. Owns what its workers refer to
+ *   (body, policy) while the launching thread goes on; deleted once the loop has ended.
+ */
+class AsyncLoopInterface {
+public:
+  virtual ~AsyncLoopInterface() {}
+
+  // Called on detached loops by the thread executing the last share
+  virtual void complete() {}
+};
+
+template <class Index, class Function, class Policy>
+class AsyncFor : public AsyncLoopInterface {
+  typedef ForWorker<Index, Function, Policy> forworker_t;
+
+  ThreadHandler &_handler;
+  const Function _local_compute;
+  const Policy _policy;
+
+public:
+  // Builds the workers of the loop on the arena of handler, whose launch mutex the caller holds
+  AsyncFor(ThreadHandler &handler, const Index first, const Index last, Function &&local_compute,
+           const Policy &policy) :
+      _handler(handler), _local_compute(std::move(local_compute)), _policy(policy) {
+    const size_t num_threads  = handler.num_threads;
+    WorkerInterface **workers = handler.workers_array.data();
+    this->_policy.distribution.start(num_threads, first, last);
+    handler.arena.reserve(num_threads, sizeof(forworker_t), alignof(forworker_t));
+    for (size_t i = 0; i < num_threads; i++)
+      workers[i] = new (handler.arena.slot(i))
+        forworker_t(i, first, last, workers, this->_local_compute, this->_policy);
+  }
+
+  ~AsyncFor() {
+    for (size_t i = 0; i < this->_handler.num_threads; i++)
+      static_cast<forworker_t *>(this->_handler.workers_array[i])->~forworker_t();
+  }
+};
+
+template <class Index, class Function, class Policy, class Completion>
+class DetachedFor : public AsyncFor<Index, Function, Policy> {
+  Completion _completion;
+
+public:
+  DetachedFor(ThreadHandler &handler, const Index first, const Index last, Function &&local_compute,
+              const Policy &policy, Completion &&completion) :
+      AsyncFor<Index, Function, Policy>(handler, first, last, std::move(local_compute), policy),
+      _completion(std::move(completion)) {}
+
+  void complete() override { this->_completion(); }
+};
+
+/*
+ * Function: can_detach
+ * --------------------------
+ *   Whether the current thread may launch a detached loop on handler: the pool has threads of its own to run it, and
+ *   the current thread neither runs a loop on it nor owns its asynchronous loop.
+ */
+inline bool can_detach(ThreadHandler &handler) {
+  return handler.num_threads > 1 && current_handler != &handler && !handler.owns_async();
+}
+
+/*
+ * Function: launch_detached_for
+ * --------------------------
+ *   Launches the loop on the threads of handler (see can_detach) and returns at once. The thread executing the last
+ *   share calls completion(), with the pool still running the loop, then releases the pool.
+ */
+template <class Index, class Function, class Policy, class Completion>
+void launch_detached_for(ThreadHandler &handler,
+                         const Index first,
+                         const Index last,
+                         Function local_compute,
+                         const Policy &policy,
+                         Completion completion) {
+  typedef DetachedFor<Index, Function, Policy, Completion> loop_t;
+  ArenaScope scope(handler); // the workers size themselves on the pool of the loop
+  handler.launch.lock();     // unlocked by the pool once the loop has ended
+  handler.launch_detached(new loop_t(handler, first, last, std::move(local_compute), policy, std::move(completion)));
+}
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
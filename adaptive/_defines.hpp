@@ -5,23 +5,15 @@
 
 #include <unistd.h>
 
-// 2 big (1 ~ 2), 4 LITTLE (0, 3 ~ 5)
-#ifdef NVIDIA_JETSON_TX2
-#define IS_LITTLE(id) ((id == 0) || (id > 2))
-
-// 4 big (4 ~ 7) 4 LITTLE (0 ~ 3)
-#elif ODROID_XU3_LITE
-#define IS_LITTLE(id) (id < 4)
-
-// no big.LITTLE
-#else
-#define IS_LITTLE(id) (id < 2)
-#endif
-
 #define MIN(x, y) ((x < y) ? x : y)
 #define MAX(x, y) ((x > y) ? x : y)
 
 #define ADPT_MAX_THREADS 256
+#define ADPT_CACHE_LINE 64
+
+// Thread-local variables of the library read by loop bodies: a single access relative to the thread pointer, instead of
+// a call to __tls_get_addr, also from the shared library
+#define ADPT_TLS_INITIAL_EXEC __attribute__((tls_model("initial-exec")))
 
 namespace adapt {
 
@@ -32,8 +24,13 @@ void stop_workers();
 namespace __internal__ // anonymous namespace
 {
 
+class Topology;
+
 size_t get_grain();
+size_t get_grain_fraction();
 size_t get_alpha();
+bool is_little(size_t thread_id);
+const Topology &get_topology();
 
 } // namespace __internal__
 } // namespace adapt
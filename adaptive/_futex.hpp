@@ -0,0 +1,139 @@
+#pragma once
+
+#ifndef _FUTEX_HPP_
+#define _FUTEX_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+/*
+ * Function: futex_wait
+ * --------------------------
+ *   Sleeps while word holds expected. Returns at once if it does not, and may return spuriously.
+ */
+inline void futex_wait(std::atomic<uint32_t> &word, const uint32_t expected) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+  if (word == expected) std::this_thread::yield();
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t> &word) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+/*
+ * Function: spin_until
+ * --------------------------
+ *   Spins with pause until done() holds or spin_ns elapsed, looking at the clock only every few iterations.
+ *
+ *   returns : done()
+ */
+template <class Done>
+inline bool spin_until(const Done &done, const uint64_t spin_ns) {
+  typedef std::chrono::steady_clock clock;
+  const clock::time_point start = clock::now();
+  for (size_t i = 1; !done(); i++) {
+    cpu_relax();
+    if ((i % 64) == 0 &&
+        uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count()) >= spin_ns)
+      return done();
+  }
+  return true;
+}
+
+/*
+ * Class: EventCount
+ * --------------------------
+ *   Lets threads out of work sleep until some condition holds. Waiters spin for a bounded time on ready(), then sleep
+ *   on a futex; whoever makes ready() hold calls notify() afterwards, which only costs a fence when nobody sleeps.
+ */
+class EventCount {
+  std::atomic<uint32_t> _epoch;    // bumped by notify() while threads sleep
+  std::atomic<uint32_t> _sleepers; // threads in futex_wait, or about to
+
+public:
+  EventCount() : _epoch(0), _sleepers(0) {}
+
+  void notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst); // orders the caller's update before reading _sleepers
+    if (this->_sleepers.load(std::memory_order_relaxed) == 0) return;
+    this->_epoch.fetch_add(1, std::memory_order_release);
+    futex_wake_all(this->_epoch);
+  }
+
+  /*
+   * Method: wait
+   * --------------------------
+   *   Returns once ready() holds, or spuriously: callers check ready() again.
+   */
+  template <class Ready>
+  void wait(const Ready &ready, const uint64_t spin_ns) {
+    if (spin_until(ready, spin_ns)) return;
+    this->_sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with notify(): it sees us, or we see its update
+    const uint32_t epoch = this->_epoch.load(std::memory_order_acquire);
+    if (!ready()) futex_wait(this->_epoch, epoch);
+    this->_sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+};
+
+/*
+ * Class: FutexMutex
+ * --------------------------
+ *   Mutex sleeping on a futex, which any thread may unlock: a loop launched by one thread can be released by the pool
+ *   thread that ends it. Lockable, for std::lock_guard and std::unique_lock.
+ */
+class FutexMutex {
+  std::atomic<uint32_t> _state; // 0: free, 1: locked, 2: locked with threads sleeping
+
+public:
+  FutexMutex() : _state(0) {}
+  FutexMutex(const FutexMutex &) = delete;
+  FutexMutex &operator=(const FutexMutex &) = delete;
+
+  bool try_lock() {
+    uint32_t expected = 0;
+    return this->_state.compare_exchange_strong(expected, 1, std::memory_order_acquire);
+  }
+
+  void lock() {
+    if (this->try_lock()) return;
+    while (this->_state.exchange(2, std::memory_order_acquire) != 0) futex_wait(this->_state, 2);
+  }
+
+  void unlock() {
+    if (this->_state.exchange(0, std::memory_order_release) == 2) futex_wake_all(this->_state);
+  }
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -0,0 +1,40 @@
+#include "_loop_history.hpp"
+
+#include "_thread_handler.hpp"
+
+namespace adapt {
+namespace __internal__ {
+
+LoopHistory::LoopHistory() : num_threads(0) {}
+
+void LoopHistory::update(size_t num_threads) {
+  uint64_t total = 0;
+  for (size_t t = 0; t < this->num_threads; t++) total += this->executed[t];
+
+  if (num_threads != this->num_threads) {
+    this->num_threads = num_threads;
+    for (size_t t = 0; t < num_threads; t++) this->share[t] = 1.0 / num_threads;
+  } else if (total > 0) {
+    const double floor = 1.0 / (8 * num_threads); // every thread starts with some work
+    double sum         = 0.0;
+    for (size_t t = 0; t < num_threads; t++) {
+      this->share[t] = MAX(0.5 * this->share[t] + 0.5 * (double(this->executed[t]) / total), floor);
+      sum += this->share[t];
+    }
+    for (size_t t = 0; t < num_threads; t++) this->share[t] /= sum;
+  }
+
+  this->bound[0] = 0.0;
+  for (size_t t = 0; t < num_threads; t++) {
+    this->bound[t + 1]  = this->bound[t] + this->share[t];
+    this->executed[t]   = 0;
+  }
+  this->bound[num_threads] = 1.0;
+}
+
+LoopHistory *get_loop_history(uintptr_t key) {
+  return &active_handler().loop_histories[key]; // element references survive rehashing
+}
+
+} // namespace __internal__
+} // namespace adapt
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifndef _LOOP_HISTORY_HPP_
+#define _LOOP_HISTORY_HPP_
+
+#include "_defines.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Struct: LoopHistory
+ * --------------------------
+ *   What the scheduler learned about one loop site: the share of the loop executed by each thread. Each run records
+ *   the iterations executed by every thread (including stolen ones), and the next run of the same site folds them into
+ *   the shares before building its initial distribution.
+ */
+struct LoopHistory {
+  size_t num_threads;                              // threads of the recorded runs, 0 before the first one
+  std::array<double, ADPT_MAX_THREADS> share;      // learned fraction of the loop executed by each thread
+  std::array<double, ADPT_MAX_THREADS + 1> bound;  // prefix sums of share
+  std::array<uint64_t, ADPT_MAX_THREADS> executed; // iterations executed by each thread on the last run
+
+  LoopHistory();
+
+  /*
+   * Method: update
+   * --------------------------
+   *   Called before a new run on num_threads threads: folds the last run into the shares (exponential moving average,
+   *   each thread keeping at least a small share), or restarts from an even split if the thread count changed.
+   */
+  void update(size_t num_threads);
+};
+
+/*
+ * Function: get_loop_history
+ * --------------------------
+ *   History of the loop site identified by key on the active pool, created empty on first use. A site run on several
+ *   pools at once, from different task arenas, has one history per pool, only used by the loop holding its launch
+ *   mutex. Histories live as long as their pool.
+ */
+LoopHistory *get_loop_history(uintptr_t key);
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
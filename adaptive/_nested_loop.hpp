@@ -0,0 +1,123 @@
+#pragma once
+
+#ifndef _NESTED_LOOP_HPP_
+#define _NESTED_LOOP_HPP_
+
+#include "_defines.hpp"
+#include "_reduction.hpp"
+#include "atomic_mutex.hpp"
+#include "cancellation_token.hpp"
+
+#include <atomic>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: NestedLoopInterface
+ * --------------------------
+ *   Loop started from inside the body of a running loop. Its thread and the threads that ran out of work on the
+ *   outer loop execute it together, claiming chunks from a shared counter.
+ */
+class NestedLoopInterface {
+public:
+  /*
+   * Method: help
+   * --------------------------
+   *   Executes chunks of the loop until none is left to claim.
+   */
+  virtual void help() = 0;
+  virtual ~NestedLoopInterface() {}
+};
+
+/*
+ * Struct: NestedSlot
+ * --------------------------
+ *   Nested loop published by one thread, and the number of threads currently looking at it. The owner unpublishes the
+ *   loop and waits for helpers to leave before destroying it.
+ */
+struct alignas(ADPT_CACHE_LINE) NestedSlot {
+  std::atomic<NestedLoopInterface *> loop;
+  std::atomic<size_t> helpers;
+
+  NestedSlot() : loop(nullptr), helpers(0) {}
+};
+
+template <class Index>
+class NestedRange {
+  std::atomic<Index> _next;
+  const Index _last;
+  const Index _chunk;
+
+public:
+  NestedRange(const Index first, const Index last, const size_t nthr) :
+      _next(first), _last(last), _chunk(MAX(Index((last > first) ? (last - first) / Index(8 * nthr) : 0), Index(1))) {}
+
+  /*
+   * Method: claim
+   * --------------------------
+   *   returns : true if it claimed the chunk [first, last)
+   */
+  bool claim(Index &first, Index &last) {
+    first = this->_next;
+    do {
+      if (!(first < this->_last)) return false;
+      last = (this->_last - first > this->_chunk) ? Index(first + this->_chunk) : this->_last;
+    } while (!this->_next.compare_exchange_weak(first, last));
+    return true;
+  }
+};
+
+template <class Index, class Function>
+class NestedFor : public NestedLoopInterface {
+  NestedRange<Index> _range;
+  const Function &_local_compute;
+  const cancellation_token &_token;
+
+public:
+  NestedFor(const Index first, const Index last, const Function &local_compute, const size_t nthr,
+            const cancellation_token &token = never_cancelled()) :
+      _range(first, last, nthr), _local_compute(local_compute), _token(token) {}
+
+  void help() override {
+    Index first, last;
+    while (!this->_token.is_cancelled() && this->_range.claim(first, last))
+      if (!this->_token.is_cancelled(first)) this->_local_compute(first, last); // else past a cancel_from()
+  }
+};
+
+template <class Index, class Function, class Value, class Reduction>
+class NestedReduce : public NestedLoopInterface {
+  NestedRange<Index> _range;
+  const Function &_local_compute;
+  const Reduction &_reduction;
+  const Value &_identity;
+  AtomicMutex _lock;
+
+public:
+  Value reduction_value;
+
+  NestedReduce(const Index first, const Index last, const Value &identity, const Function &local_compute,
+               const Reduction &reduction, const size_t nthr) :
+      _range(first, last, nthr), _local_compute(local_compute), _reduction(reduction), _identity(identity),
+      reduction_value(identity) {}
+
+  void help() override {
+    Index first, last;
+    if (!this->_range.claim(first, last)) return;
+    Value partial_value(this->_identity);
+    do {
+      accumulate(this->_local_compute, first, last, partial_value, this->_identity, this->_reduction);
+    } while (this->_range.claim(first, last));
+
+    this->_lock.lock(); // once per helper
+    combine(this->_reduction, this->reduction_value, std::move(partial_value));
+    this->_lock.unlock();
+  }
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
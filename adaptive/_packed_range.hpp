@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef _PACKED_RANGE_HPP_
+#define _PACKED_RANGE_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Struct: uses_packed_range
+ * --------------------------
+ *   Sub-ranges of indices up to 32 bits keep [first, last) in a single 64-bit atomic word, so the owner extracts and
+ *   thieves steal with a CAS and no lock. Wider indices keep the lock-based protocol. Defining LOCKED_RANGES forces
+ *   the lock-based protocol on every index type.
+ */
+template <class Index>
+struct uses_packed_range
+    : std::integral_constant<bool,
+#ifdef LOCKED_RANGES
+                             false
+#else
+                             std::is_integral<Index>::value && (sizeof(Index) <= sizeof(uint32_t))
+#endif
+                             > {
+};
+
+/*
+ * Struct: PackedRange
+ * --------------------------
+ *   [first, last) of a sub-range as one atomic word: first on the low half, last on the high half.
+ */
+template <class Index>
+struct PackedRange {
+  std::atomic<uint64_t> word;
+
+  static uint64_t pack(const Index first, const Index last) {
+    return uint64_t(uint32_t(first)) | (uint64_t(uint32_t(last)) << 32);
+  }
+  static Index first_of(const uint64_t word) { return Index(uint32_t(word)); }
+  static Index last_of(const uint64_t word) { return Index(uint32_t(word >> 32)); }
+};
+
+/*
+ * Class: PackedBound
+ * --------------------------
+ *   Read-only view of one end of a PackedRange, so policies read worker.first and worker.last whatever the protocol.
+ */
+template <class Index, bool Last>
+class PackedBound {
+  const PackedRange<Index> *_range;
+
+public:
+  PackedBound() : _range(nullptr) {}
+
+  void bind(const PackedRange<Index> &range) { this->_range = &range; }
+
+  operator Index() const {
+    const uint64_t word = this->_range->word;
+    return Last ? PackedRange<Index>::last_of(word) : PackedRange<Index>::first_of(word);
+  }
+};
+
+/*
+ * Struct: NoPackedRange
+ * --------------------------
+ *   Stands for the packed word on workers using the lock-based protocol.
+ */
+struct NoPackedRange {};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -9,27 +9,33 @@ namespace adapt {
 namespace __internal__ // anonymous namespace
 {
 
-template <class Index, class Function>
-class ForWorker : public Worker<Index> {
+template <class Index, class Function, class Policy = default_policy>
+class ForWorker : public Worker<Index, Policy> {
   const Function &local_compute;
 
 public:
   ForWorker(const size_t thr_id,
             const Index global_first,
             const Index global_last,
-            std::vector<Worker<Index> *> *workers_array,
-            const Function &_local_compute) :
-      Worker<Index>(thr_id, global_first, global_last, workers_array),
+            WorkerInterface **workers_array,
+            const Function &_local_compute,
+            const Policy &policy = Policy(),
+            const cancellation_token &token = never_cancelled()) :
+      Worker<Index, Policy>(thr_id, global_first, global_last, workers_array, policy, token),
       local_compute(_local_compute) {}
 
   virtual void work() override {
     while (true) {                // Iterates while there are work to be done
-      while (this->extract_seq()) // Iterates while there are sequential work to be done
+      while (this->extract_seq()) { // Iterates while there are sequential work to be done
+        this->chunk_started();
         local_compute(this->_working_first, this->_working_last);
+        this->chunk_finished();
+      }
 
-      // Tries to steal work. If there are no work to steal, exits
-      if (!this->extract_par()) return;
+      // Takes the next sub-range of the distribution or tries to steal work. If there are no work to steal, exits
+      if (!this->extract_next() && !this->extract_par()) break;
     }
+    this->work_finished();
   }
 };
 
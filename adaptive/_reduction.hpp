@@ -0,0 +1,96 @@
+#pragma once
+
+#ifndef _REDUCTION_HPP_
+#define _REDUCTION_HPP_
+
+#include <type_traits>
+#include <utility>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Reduction signatures
+ * ---------------------------
+ *   A reduction body either returns a new value, value = body(first, last, identity), or accumulates [first, last) in
+ *   place, body(first, last, value&) returning void. A reduction function either returns the combination,
+ *   left = reduction(left, right), or combines in place, reduction(left&, right&&) returning void. In-place forms
+ *   never copy the value, for heavy types (containers, histograms).
+ */
+template <class Function, class Index, class Value>
+struct accumulates_in_place
+    : std::is_void<decltype(std::declval<const Function &>()(std::declval<Index>(), std::declval<Index>(),
+                                                              std::declval<Value &>()))> {};
+
+template <class...>
+struct make_void {
+  typedef void type;
+};
+
+// Whether reduction(left&, right&&) is well-formed; else the right value is passed as an lvalue, as reduction(V&, V&)
+template <class Reduction, class Value, class = void>
+struct takes_rvalue : std::false_type {};
+
+template <class Reduction, class Value>
+struct takes_rvalue<Reduction, Value,
+                    typename make_void<decltype(std::declval<const Reduction &>()(std::declval<Value &>(),
+                                                                                  std::declval<Value &&>()))>::type>
+    : std::true_type {};
+
+template <class Reduction, class Value>
+using right_operand = typename std::conditional<takes_rvalue<Reduction, Value>::value, Value &&, Value &>::type;
+
+template <class Reduction, class Value>
+struct combines_in_place
+    : std::is_void<decltype(std::declval<const Reduction &>()(std::declval<Value &>(),
+                                                              std::declval<right_operand<Reduction, Value>>()))> {};
+
+template <class Reduction, class Value>
+void combine(const Reduction &reduction, Value &left, Value &&right, std::true_type) {
+  reduction(left, static_cast<right_operand<Reduction, Value>>(right));
+}
+
+template <class Reduction, class Value>
+void combine(const Reduction &reduction, Value &left, Value &&right, std::false_type) {
+  left = reduction(left, static_cast<right_operand<Reduction, Value>>(right));
+}
+
+/*
+ * Function: combine
+ * ---------------------------
+ *   Combines right into left, moving right unless the reduction only takes lvalues.
+ */
+template <class Reduction, class Value>
+void combine(const Reduction &reduction, Value &left, Value &&right) {
+  combine(reduction, left, std::move(right), combines_in_place<Reduction, Value>());
+}
+
+template <class Function, class Index, class Value, class Reduction>
+void accumulate(const Function &local_compute, const Index first, const Index last, Value &value, const Value &,
+                const Reduction &, std::true_type) {
+  local_compute(first, last, value);
+}
+
+template <class Function, class Index, class Value, class Reduction>
+void accumulate(const Function &local_compute, const Index first, const Index last, Value &value,
+                const Value &identity, const Reduction &reduction, std::false_type) {
+  combine(reduction, value, Value(local_compute(first, last, identity)));
+}
+
+/*
+ * Function: accumulate
+ * ---------------------------
+ *   Combines the reduction of [first, last) into value.
+ */
+template <class Function, class Index, class Value, class Reduction>
+void accumulate(const Function &local_compute, const Index first, const Index last, Value &value,
+                const Value &identity, const Reduction &reduction) {
+  accumulate(local_compute, first, last, value, identity, reduction,
+             accumulates_in_place<Function, Index, Value>());
+}
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -3,17 +3,18 @@
 #ifndef _REDUCTION_WORKER_
 #define _REDUCTION_WORKER_
 
+#include "_reduction.hpp"
 #include "_worker.hpp"
 
 namespace adapt {
 namespace __internal__ // anonymous namespace
 {
 
-template <class Index, class Function, class Value, class Reduction>
-class ReductionWorker : public Worker<Index> {
+template <class Index, class Function, class Value, class Reduction, class Policy = default_policy>
+class ReductionWorker : public Worker<Index, Policy> {
   const Function &local_compute;
   const Reduction &reduction;
-  const Value identity;
+  const Value &identity; // of parallel_reduce, alive until the loop ends
 
 public:
   Value reduction_value;
@@ -22,11 +23,12 @@ public:
   ReductionWorker(const size_t thr_id,
                   const Index global_first,
                   const Index global_last,
-                  const Value _identity,
-                  std::vector<Worker<Index> *> *workers_array,
+                  const Value &_identity,
+                  WorkerInterface **workers_array,
                   const Function &_local_compute,
-                  const Reduction &_reduction) :
-      Worker<Index>(thr_id, global_first, global_last, workers_array),
+                  const Reduction &_reduction,
+                  const Policy &policy = Policy()) :
+      Worker<Index, Policy>(thr_id, global_first, global_last, workers_array, policy),
       local_compute(_local_compute), reduction(_reduction), identity(_identity), reduction_value(_identity) {
     red_lock.lock();
   }
@@ -36,22 +38,24 @@ public:
   virtual void work() override {
     while (true) {                  // Iterates while there are work to be done
       while (this->extract_seq()) { // Iterates while there are sequential work to be done
-        const Value partial_value = this->local_compute(this->_working_first, this->_working_last, identity);
-        reduction_value           = reduction(reduction_value, partial_value);
+        this->chunk_started();
+        accumulate(local_compute, this->_working_first, this->_working_last, reduction_value, identity, reduction);
+        this->chunk_finished();
       }
 
-      // Tries to steal work. If there are no work to steal, exits
-      if (!this->extract_par()) break;
+      // Takes the next sub-range of the distribution or tries to steal work. If there are no work to steal, exits
+      if (!this->extract_next() && !this->extract_par()) break;
     }
+    this->work_finished();
 
     // tree reduction
     for (int i = 2;; i <<= 1) {
       if ((this->_id % i) == 0) {
         const int an_thr = this->_id + (i >> 1);
         if (an_thr < this->_nthr) {
-          ReductionWorker *an_worker = static_cast<ReductionWorker *>(this->_workers_array->at(an_thr));
+          ReductionWorker *an_worker = static_cast<ReductionWorker *>(this->_workers_array[an_thr]);
           an_worker->red_lock.lock();
-          reduction_value = reduction(reduction_value, an_worker->reduction_value);
+          combine(reduction, reduction_value, std::move(an_worker->reduction_value));
           an_worker->red_lock.unlock();
           continue;
         }
@@ -0,0 +1,189 @@
+#pragma once
+
+#ifndef _SCAN_HPP_
+#define _SCAN_HPP_
+
+#include "_defines.hpp"
+#include "atomic_mutex.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: Scan
+ * --------------------------
+ *   State of an adaptive prefix scan. Each thread scans the chunks it extracts in index order, in runs of contiguous
+ *   chunks. A run starting where the prefix is known (the loop start, or the end of a finished final run) is scanned
+ *   for good (final). A run starting on a stolen sub-range is only summed (pre-scanned), in pieces, until the run
+ *   before it finishes and publishes the prefix at its start; the run then turns final. Once the loop is over, the
+ *   prefixes of the pre-scanned pieces are resolved in index order, and only those pieces are scanned again.
+ *
+ *   body(first, last, prefix, is_final) returns prefix combined with [first, last), and writes the scan of [first,
+ *   last) if is_final. combine(left, right) joins the values of two adjacent sub-ranges.
+ */
+template <class Index, class Value, class Body, class Combine>
+class Scan {
+public:
+  struct Segment {
+    Index first, last;
+    Value value; // prefix at last if final, else sum of [first, last)
+    bool final;
+
+    bool operator<(const Segment &other) const { return this->first < other.first; }
+  };
+
+  struct Rescan {
+    Index first, last;
+    Value prefix; // at first
+  };
+
+  Scan(const Index first, const Index last, const Value &identity, const Body &body, const Combine &combine,
+       const size_t nthr) :
+      _identity(identity),
+      _body(body),
+      _combine(combine),
+      _piece(MAX(Index((last > first) ? (last - first) / Index(8 * nthr) : 0), Index(1))),
+      _slots(nthr, Slot(identity)),
+      _published(1, std::make_pair(first, identity)),
+      _count(1) {}
+
+  /*
+   * Method: chunk
+   * --------------------------
+   *   Scans [first, last) as extracted by thread id.
+   */
+  void chunk(const size_t id, const Index first, const Index last) {
+    Slot &slot = this->_slots[id];
+    if (!slot.open || first != slot.position) { // starts a new run
+      this->close(slot);
+      slot.open        = true;
+      slot.run_first   = first;
+      slot.final_first = first;
+      slot.piece_first = first;
+      slot.position    = first;
+      slot.run_pieces  = slot.segments.size();
+      slot.seen        = this->_count.load(std::memory_order_acquire);
+      slot.final       = this->lookup(first, slot.carry);
+      if (!slot.final) slot.carry = this->_identity;
+    } else if (!slot.final && slot.seen != this->_count.load(std::memory_order_acquire)) {
+      slot.seen = this->_count.load(std::memory_order_acquire);
+      Value prefix(this->_identity);
+      if (this->lookup(slot.run_first, prefix)) this->turn_final(slot, prefix);
+    }
+
+    slot.carry    = this->_body(first, last, slot.carry, slot.final);
+    slot.position = last;
+    if (!slot.final && (last - slot.piece_first) >= this->_piece) { // pieces are rescanned in parallel
+      slot.segments.push_back(Segment{slot.piece_first, last, slot.carry, false});
+      slot.piece_first = last;
+      slot.carry       = this->_identity;
+    }
+  }
+
+  /*
+   * Method: resolve
+   * --------------------------
+   *   Closes the runs of every thread and sets the prefix of each pre-scanned piece. Called once the loop is over.
+   *
+   *   returns : prefix at the end of the loop
+   */
+  Value resolve(std::vector<Rescan> &rescans) {
+    std::vector<Segment> segments;
+    for (Slot &slot : this->_slots) {
+      this->close(slot);
+      for (const Segment &segment : slot.segments)
+        if (segment.first < segment.last) segments.push_back(segment);
+    }
+    std::sort(segments.begin(), segments.end());
+
+    Value prefix(this->_identity);
+    for (const Segment &segment : segments) {
+      if (segment.final) {
+        prefix = segment.value;
+      } else {
+        rescans.push_back(Rescan{segment.first, segment.last, prefix});
+        prefix = this->_combine(prefix, segment.value);
+      }
+    }
+    return prefix;
+  }
+
+  void rescan(const Rescan &piece) const { this->_body(piece.first, piece.last, piece.prefix, true); }
+
+private:
+  struct Slot {
+    std::vector<Segment> segments; // closed pieces and final runs
+    bool open, final;
+    Index run_first, final_first, piece_first, position; // position: end of the last chunk of the run
+    size_t run_pieces;                                    // first piece of the run on segments
+    size_t seen;                                          // publications seen
+    Value carry; // prefix at position if final, else sum of [piece_first, position)
+    char _pad[ADPT_CACHE_LINE]; // threads scan on their own slots
+
+    Slot(const Value &identity) :
+        open(false), final(false), run_first(), final_first(), piece_first(), position(), run_pieces(0), seen(0),
+        carry(identity), _pad() {}
+  };
+
+  // Prefix at position, if a final run ending there was published
+  bool lookup(const Index position, Value &prefix) {
+    bool found = false;
+    this->_lock.lock();
+    for (const std::pair<Index, Value> &published : this->_published) {
+      if (published.first == position) {
+        prefix = published.second;
+        found  = true;
+        break;
+      }
+    }
+    this->_lock.unlock();
+    return found;
+  }
+
+  // The prefix at the start of the run is known: what was summed so far becomes pieces to rescan
+  void turn_final(Slot &slot, Value prefix) {
+    if (slot.piece_first < slot.position) {
+      slot.segments.push_back(Segment{slot.piece_first, slot.position, slot.carry, false});
+      slot.piece_first = slot.position;
+    }
+    for (size_t i = slot.run_pieces; i < slot.segments.size(); i++)
+      prefix = this->_combine(prefix, slot.segments[i].value);
+    slot.final       = true;
+    slot.final_first = slot.position;
+    slot.carry       = prefix;
+  }
+
+  void close(Slot &slot) {
+    if (!slot.open) return;
+    slot.open = false;
+    if (slot.final) {
+      slot.segments.push_back(Segment{slot.final_first, slot.position, slot.carry, true});
+      this->_lock.lock();
+      this->_published.push_back(std::make_pair(slot.position, slot.carry));
+      this->_lock.unlock();
+      this->_count.fetch_add(1, std::memory_order_release);
+    } else if (slot.piece_first < slot.position) {
+      slot.segments.push_back(Segment{slot.piece_first, slot.position, slot.carry, false});
+    }
+  }
+
+  const Value _identity;
+  const Body &_body;
+  const Combine &_combine;
+  const Index _piece; // size of the pieces of a pre-scanned run
+  std::vector<Slot> _slots;
+  std::vector<std::pair<Index, Value>> _published; // prefixes at the end of final runs
+  AtomicMutex _lock;
+  std::atomic<size_t> _count; // size of _published
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -0,0 +1,64 @@
+#include "_task_pool.hpp"
+
+namespace adapt {
+namespace __internal__ {
+
+TaskPool::TaskPool() : _num_queues(0), _idle(nullptr), _queued(0) {}
+
+TaskPool::~TaskPool() {
+  for (size_t i = 0; i < this->_num_queues; i++) // tasks of groups never waited for
+    for (size_t t = this->_queues[i].head; t < this->_queues[i].tasks.size(); t++) delete this->_queues[i].tasks[t];
+}
+
+void TaskPool::init(size_t num_queues, EventCount &idle) {
+  this->_queues.reset(new Queue[num_queues]);
+  this->_num_queues = num_queues;
+  this->_idle       = &idle;
+}
+
+void TaskPool::push(size_t id, TaskInterface *task) {
+  Queue &queue = this->_queues[id % this->_num_queues];
+  this->_queued++; // before the task can be taken, which decrements it
+  queue.lock.lock();
+  queue.tasks.push_back(task);
+  queue.lock.unlock();
+  this->_idle->notify();
+}
+
+TaskInterface *TaskPool::take(size_t id, bool own) {
+  Queue &queue        = this->_queues[id];
+  TaskInterface *task = nullptr;
+  queue.lock.lock();
+  if (queue.head < queue.tasks.size()) {
+    if (own) {
+      task = queue.tasks.back();
+      queue.tasks.pop_back();
+    } else {
+      task = queue.tasks[queue.head++];
+    }
+    if (queue.head == queue.tasks.size()) { // empty: reuses the storage
+      queue.tasks.clear();
+      queue.head = 0;
+    }
+  }
+  queue.lock.unlock();
+  return task;
+}
+
+bool TaskPool::execute_one(size_t id) {
+  if (this->_queued.load(std::memory_order_acquire) == 0) return false;
+  id                  = id % this->_num_queues;
+  TaskInterface *task = this->take(id, true);
+  for (size_t i = 1; !task && i < this->_num_queues; i++) task = this->take((id + i) % this->_num_queues, false);
+  if (!task) return false;
+
+  this->_queued--;
+  std::atomic<size_t> *pending = task->pending;
+  task->execute();
+  delete task;
+  if (pending->fetch_sub(1, std::memory_order_release) == 1) this->_idle->notify(); // the group may be gone now
+  return true;
+}
+
+} // namespace __internal__
+} // namespace adapt
@@ -0,0 +1,93 @@
+#pragma once
+
+#ifndef _TASK_POOL_HPP_
+#define _TASK_POOL_HPP_
+
+#include "_defines.hpp"
+#include "_futex.hpp"
+#include "atomic_mutex.hpp"
+
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: TaskInterface
+ * --------------------------
+ *   Function spawned by a task_group, allocated by run() and deleted once executed. Executing it decrements the
+ *   number of pending tasks of its group.
+ */
+class TaskInterface {
+public:
+  std::atomic<size_t> *pending; // of the task group
+
+  TaskInterface(std::atomic<size_t> &_pending) : pending(&_pending) {}
+  virtual void execute() = 0;
+  virtual ~TaskInterface() {}
+};
+
+template <class Function>
+class Task : public TaskInterface {
+  Function _function;
+
+public:
+  template <class F>
+  Task(F &&function, std::atomic<size_t> &pending) : TaskInterface(pending), _function(std::forward<F>(function)) {}
+
+  void execute() override { this->_function(); }
+};
+
+/*
+ * Class: TaskPool
+ * --------------------------
+ *   Pending tasks of the threads of a pool, one queue per thread. A thread pushes and takes back its own tasks last in
+ *   first out, so divide and conquer goes depth first; threads without tasks steal the oldest task of another queue.
+ */
+class TaskPool {
+  struct Queue {
+    AtomicMutex lock;
+    std::vector<TaskInterface *> tasks;
+    size_t head; // tasks before head were stolen
+    char _pad[ADPT_CACHE_LINE]; // threads push on their own queues
+
+    Queue() : head(0) {}
+  };
+
+  std::unique_ptr<Queue[]> _queues;
+  size_t _num_queues;
+  EventCount *_idle; // of the threads of the pool, notified of new tasks and of groups done
+  alignas(ADPT_CACHE_LINE) std::atomic<size_t> _queued; // tasks on every queue, counted before pushed
+
+  TaskInterface *take(size_t id, bool own);
+
+public:
+  TaskPool();
+  ~TaskPool();
+
+  void init(size_t num_queues, EventCount &idle);
+
+  // Pushes task on the queue of thread id
+  void push(size_t id, TaskInterface *task);
+
+  // Whether some task waits on a queue
+  bool queued() const { return this->_queued.load(std::memory_order_acquire) > 0; }
+
+  /*
+   * Method: execute_one
+   * --------------------------
+   *   Executes one pending task, taken from the queue of thread id or else stolen from another one.
+   *
+   *   returns : false if there was no task to execute
+   */
+  bool execute_one(size_t id);
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
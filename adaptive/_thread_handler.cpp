@@ -1,6 +1,10 @@
 #include "_thread_handler.hpp"
 
+#include "_async_loop.hpp"
+#include "_futex.hpp"
+
 #include <pthread.h>
+#include <string>
 #include <thread>
 
 namespace adapt {
@@ -15,46 +19,68 @@ static size_t get_from_env(std::string var, size_t default_value) {
   return value;
 }
 
-static void pin_thread(cpu_set_t *cpuset, const int thread_id) {
-  const int core = thread_id % std::max(std::thread::hardware_concurrency(), 1u);
-  // printf("Pinning Thread %d on core %d\n", thread_id, core);
+static std::string get_string_from_env(std::string var, std::string default_value) {
+  const char *env_var = getenv(var.c_str());
+  return (env_var && *env_var) ? std::string(env_var) : default_value;
+}
+
+static void pin_thread(cpu_set_t *cpuset, const int core) {
+  // printf("Pinning Thread on core %d\n", core);
   CPU_SET(core, cpuset);
   pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), cpuset);
 }
 
-ThreadHandler::ThreadHandler() : stop(true), counter(1) {
-  this->master      = pthread_self();
+ThreadHandler::ThreadHandler() : stop(true), pin(true), counter(1) {
   this->num_threads = get_from_env("ADAPT_NUM_THREADS", std::max(std::thread::hardware_concurrency(), 1u));
-  this->alpha       = get_from_env("ADAPT_ALPHA", 1);
-#ifdef GRAIN_FRACTION
-  this->grain = get_from_env("ADAPT_GRAIN", 256);
-#else
-  this->grain = get_from_env("ADAPT_GRAIN", 1);
-#endif
+  this->init(get_from_env("ADAPT_CALIBRATE", 0), std::vector<int>());
+}
+
+ThreadHandler::ThreadHandler(size_t num_threads, const std::vector<int> &cpus) :
+    stop(true), pin(!cpus.empty()), counter(1) {
+  this->num_threads = MIN(MAX(num_threads, size_t(1)), size_t(ADPT_MAX_THREADS));
+  this->init(false, cpus);
+}
+
+void ThreadHandler::init(bool calibrate, const std::vector<int> &cpus) {
+  this->master         = pthread_self();
+  this->grain          = get_from_env("ADAPT_GRAIN", 1);
+  this->grain_fraction = get_from_env("ADAPT_GRAIN", 256); // fraction_grain
+  this->workers_array.fill(nullptr);
+  this->tasks.init(this->num_threads, this->idle);
+  this->detached         = nullptr;
+  this->async_owner      = 0;
+  this->detached_loop    = nullptr;
+  this->detached_threads = 0;
+  this->topology.discover(this->num_threads, calibrate, cpus);
+  this->alpha = get_from_env("ADAPT_ALPHA", this->topology.alpha()); // measured unless explicitly set
+  this->barrier.reset(make_barrier(get_string_from_env("ADAPT_BARRIER", "central"), this->topology));
+  if (!this->barrier) this->barrier.reset(new CentralBarrier()); // unknown algorithm
 
   this->start_threads();
 }
 
 ThreadHandler::~ThreadHandler() { this->stop_threads(); }
 
-inline bool ThreadHandler::in_master() { return this->master == pthread_self(); }
-
 void ThreadHandler::start_threads() {
   if (this->stop) {
     this->stop = false;
-    this->barrier.set_participants(this->num_threads);
+    this->barrier->set_participants(this->num_threads);
+    this->spin_ns = get_from_env("ADAPT_SPIN_US", HybridBarrier::DEFAULT_SPIN_NS / 1000) * 1000;
+    this->barrier->set_spin(this->spin_ns);
     for (size_t i = 1; i < this->num_threads; i++) {
       pthread_create(&this->threads[i], nullptr, ThreadHandler::spawn_worker, this);
     }
-    ThreadHandler::spawn_worker(this);
+    if (this->pin && this->master == pthread_self()) pin_thread(&this->cpusets[0], this->topology.cpu(0));
   }
 }
 
 void ThreadHandler::stop_threads() {
   if (!this->stop) {
-    this->stop    = true; // tells other threads to stop
-    this->counter = 1;    // now only running on 1 thread
-    this->barrier.wait(); // free barrier
+    this->launch.lock(); // waits for a detached loop
+    this->launch.unlock();
+    this->stop    = true;   // tells other threads to stop
+    this->counter = 1;      // now only running on 1 thread
+    this->barrier->wait(0); // free barrier
     for (size_t i = 1; i < this->num_threads; i++) {
       pthread_join(this->threads[i], nullptr);
       this->threads[i] = 0;
@@ -64,34 +90,160 @@ void ThreadHandler::stop_threads() {
 
 void ThreadHandler::work(int my_id) {
   do {
-    this->barrier.wait();  // wait for worker creation
-    if (this->stop) break; // program exited
+    this->barrier->wait(my_id); // wait for worker creation
+    if (this->stop) break;      // program exited
 
+    const bool joined         = this->detached_loop == nullptr; // read before the loop can end
     WorkerInterface &m_worker = *(this->workers_array[my_id]);
+    current_thread_id         = my_id;
+    current_handler           = this;
     m_worker.work();
 
-    if (!this->in_master()) this->barrier.wait(); // wait for posterior worker deletion
-  } while (!this->in_master());                   // do not loop if master thread
+    // Out of work: helps the nested loops and tasks of the threads still busy on this one
+    this->leave_loop();
+    this->run_detached();
+    this->help_until_done(my_id);
+    current_thread_id = -1;
+    current_handler   = nullptr;
+
+    if (my_id == 0) break; // launching thread: does not loop
+    if (joined)
+      this->barrier->wait(my_id); // wait for posterior worker deletion
+    else if (--this->detached_threads == 0)
+      this->launch.unlock(); // last thread out of a detached loop: the next loop may start
+  } while (true);
+}
+
+bool ThreadHandler::run_detached() {
+  if (this->detached.load(std::memory_order_relaxed) == nullptr) return false; // no asynchronous loop
+  WorkerInterface *worker = this->detached.exchange(nullptr);
+  if (worker == nullptr) return false;
+  worker->work();
+  this->leave_loop();
+  return true;
+}
+
+void ThreadHandler::leave_loop() {
+  const size_t left = this->active.fetch_sub(1) - 1;
+  if (left == 0)
+    this->idle.notify();
+  else if (left == 1 && this->detached_loop != nullptr) // every share is over: the pool is held for the completion
+    this->end_detached();
+}
+
+void ThreadHandler::end_detached() {
+  AsyncLoopInterface *loop = this->detached_loop;
+  loop->complete();
+  this->detached_loop = nullptr;
+  delete loop; // no thread executes workers anymore
+  this->leave_loop();
+}
+
+void ThreadHandler::help_until_done(int my_id) {
+  while (this->active > 0)
+    if (!this->help_nested() && !this->tasks.execute_one(my_id)) this->wait_for([this]() { return this->active == 0; });
+}
+
+void ThreadHandler::launch_async() {
+  this->active      = this->num_threads;
+  this->detached    = this->workers_array[0];
+  this->async_owner = pthread_self();
+  this->barrier->wait(0); // other threads start
+}
+
+void ThreadHandler::launch_detached(AsyncLoopInterface *loop) {
+  this->detached_loop    = loop;
+  this->detached_threads = this->num_threads - 1;
+  this->active           = this->num_threads + 1; // the shares, and the completion
+  this->detached      = this->workers_array[0];
+  this->barrier->wait(0); // other threads start, the first one out of work takes the share of this one
+}
+
+void ThreadHandler::join_async() {
+  current_thread_id = 0;
+  current_handler   = this;
+  this->run_detached();
+  this->help_until_done(0);
+  current_thread_id = -1;
+  current_handler   = nullptr;
+  this->async_owner = 0;
+  this->barrier->wait(0);
+}
+
+bool ThreadHandler::owns_async() const { return this->async_owner.load(std::memory_order_relaxed) == pthread_self(); }
+
+void ThreadHandler::run_nested(NestedLoopInterface &loop) {
+  if (current_thread_id < 0) { // launcher of the asynchronous loop, outside of it
+    current_thread_id = 0;
+    current_handler   = this;
+    this->run_nested(loop);
+    current_thread_id = -1;
+    current_handler   = nullptr;
+    return;
+  }
+  NestedSlot &slot = this->nested[current_thread_id];
+  if (slot.loop != nullptr) { // this thread already publishes a loop up the stack
+    loop.help();
+    return;
+  }
+  slot.loop = &loop;
+  this->idle.notify();
+  loop.help();
+  slot.loop = nullptr;
+  while (slot.helpers > 0) cpu_relax(); // helpers may still be executing their last chunks
+}
+
+bool ThreadHandler::help_nested() {
+  bool published = false;
+  for (size_t t = 0; t < this->num_threads; t++) {
+    NestedSlot &slot = this->nested[t];
+    if (slot.loop == nullptr) continue;
+    slot.helpers++; // before reading the loop again: keeps its owner from leaving
+    NestedLoopInterface *loop = slot.loop;
+    if (loop) {
+      loop->help();
+      published = true;
+    }
+    slot.helpers--;
+  }
+  return published;
+}
+
+bool ThreadHandler::has_work() const {
+  if (this->tasks.queued()) return true;
+  for (size_t t = 0; t < this->num_threads; t++)
+    if (this->nested[t].loop.load(std::memory_order_relaxed) != nullptr) return true;
+  return false;
 }
 
 // pthread callback
 void *ThreadHandler::spawn_worker(void *ptr) {
   ThreadHandler *self = static_cast<ThreadHandler *>(ptr);
-  int my_id           = (self->in_master()) ? 0 : self->counter++;
-  pin_thread(&self->cpusets[my_id], my_id);
-  if (my_id) self->work(my_id);
+  int my_id           = self->counter++;
+  if (self->pin) pin_thread(&self->cpusets[my_id], self->topology.cpu(my_id));
+  self->work(my_id);
   return nullptr;
 }
 
 ThreadHandler thread_handler;
 
-size_t get_alpha() { return thread_handler.alpha; }
+thread_local int current_thread_id ADPT_TLS_INITIAL_EXEC         = -1;
+thread_local ThreadHandler *current_handler ADPT_TLS_INITIAL_EXEC  = nullptr;
+thread_local ThreadHandler *selected_handler ADPT_TLS_INITIAL_EXEC = nullptr;
+
+size_t get_alpha() { return active_handler().alpha; }
+
+bool is_little(size_t thread_id) { return active_handler().topology.is_little(thread_id); }
+
+size_t get_grain() { return active_handler().grain; }
+
+size_t get_grain_fraction() { return active_handler().grain_fraction; }
 
-size_t get_grain() { return thread_handler.grain; }
+const Topology &get_topology() { return active_handler().topology; }
 
 } // namespace __internal__
 
-size_t get_num_threads() { return __internal__::thread_handler.num_threads; }
+size_t get_num_threads() { return __internal__::active_handler().num_threads; }
 
 void start_workers() { __internal__::thread_handler.start_threads(); }
 
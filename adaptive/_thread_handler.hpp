@@ -3,40 +3,148 @@
 #ifndef _THREAD_HANDLER_HPP_
 #define _THREAD_HANDLER_HPP_
 
+#include "_futex.hpp"
+#include "_loop_history.hpp"
+#include "_nested_loop.hpp"
+#include "_task_pool.hpp"
+#include "_topology.hpp"
 #include "_worker.hpp"
+#include "_worker_arena.hpp"
 #include "atomic_barrier.hpp"
+#include "barrier.hpp"
+#include "hybrid_barrier.hpp"
 
 #include <array>
 #include <atomic>
+#include <memory>
 #include <sched.h>
+#include <unordered_map>
+#include <vector>
 
 namespace adapt {
 namespace __internal__ // anonymous namespace
 {
 
+class AsyncLoopInterface;
+
+/*
+ * Class: ThreadHandler
+ * --------------------------
+ *   Pool of threads running the loops of the program (the global thread_handler) or of a task_arena. The thread
+ *   launching a loop, whichever it is, works on it as thread 0; loops launched by several threads on the same pool
+ *   run one after the other.
+ */
 class ThreadHandler {
 private:
   bool stop;
+  bool pin; // pins thread i on topology.cpu(i)
   std::array<unsigned long, ADPT_MAX_THREADS> threads;
-  bool in_master();
+  void init(bool calibrate, const std::vector<int> &cpus);
   void start_threads();
   void stop_threads();
+  bool run_detached();             // runs the share of thread 0 of an asynchronous loop, if no thread took it yet
+  void help_until_done(int my_id); // helps nested loops and tasks, or sleeps, until no thread works on the loop
+  void leave_loop();               // after executing the share of a worker
+  void end_detached();             // by the thread executing the last share of a detached loop
 
 public:
   unsigned long master;
   size_t num_threads;
   size_t alpha;
   size_t grain;
+  size_t grain_fraction;
   std::atomic<int> counter;
-  AtomicBarrier barrier;
+  std::unique_ptr<Barrier> barrier; // ADAPT_BARRIER algorithm; spins, then sleeps
+  uint64_t spin_ns;                 // ADAPT_SPIN_US: time waiting threads spin before sleeping
   std::array<cpu_set_t, ADPT_MAX_THREADS> cpusets;
+  Topology topology;
   std::array<WorkerInterface *, ADPT_MAX_THREADS> workers_array;
+  WorkerArena arena; // storage reused by the workers of every loop
+  alignas(ADPT_CACHE_LINE) std::atomic<size_t> active; // threads still working on the outer loop
+  std::array<NestedSlot, ADPT_MAX_THREADS> nested;      // nested loop published by each thread
+  TaskPool tasks;                                       // queued tasks of the task_groups on this pool
+  EventCount idle;                                      // threads out of work sleep on it until there is work
+  std::atomic<WorkerInterface *> detached;              // share of thread 0 of an asynchronous loop, until taken
+  std::atomic<unsigned long> async_owner;               // thread that launched the asynchronous loop, until it joins
+  FutexMutex launch;                                    // held by the thread running a loop, or by a detached loop
+  AsyncLoopInterface *detached_loop;                    // loop of launch_detached, ended by the pool itself
+  std::atomic<size_t> detached_threads;                 // threads of the pool not yet out of the detached loop
+
+  // Histories of the learned_distribution sites run on this pool, used under its launch mutex
+  std::unordered_map<uintptr_t, LoopHistory> loop_histories;
 
+  // Global pool: threads and configuration from the ADAPT_* environment variables, the main thread pinned as thread 0
   ThreadHandler();
+  // Pool of a task_arena: num_threads threads, pinned on cpus if given
+  ThreadHandler(size_t num_threads, const std::vector<int> &cpus);
   ~ThreadHandler();
   void work(int my_id);
   static void *spawn_worker(void *ptr);
 
+  /*
+   * Method: run_nested
+   * --------------------------
+   *   Runs a loop started from the body of a running loop: publishes it for threads done with the outer loop and
+   *   helps executing it. A thread already running a nested loop of its own runs the new one serially. The thread
+   *   that launched the asynchronous loop of the pool nests its loops in it, as thread 0, until it joins.
+   */
+  void run_nested(NestedLoopInterface &loop);
+
+  /*
+   * Method: help_nested
+   * --------------------------
+   *   Executes chunks of every published nested loop. Called by threads out of work, which then execute queued tasks.
+   *
+   *   returns : true if some loop was published
+   */
+  bool help_nested();
+
+  /*
+   * Method: has_work
+   * --------------------------
+   *   Whether some nested loop is published or some task queued, for threads out of work to help with.
+   */
+  bool has_work() const;
+
+  /*
+   * Method: wait_for
+   * --------------------------
+   *   Spins for spin_ns, then sleeps, until done() holds or there is work to help with. May return spuriously.
+   */
+  template <class Done>
+  void wait_for(const Done &done) {
+    this->idle.wait([&]() { return done() || this->has_work(); }, this->spin_ns);
+  }
+
+  /*
+   * Method: launch_async
+   * --------------------------
+   *   Starts the loop of workers_array on the other threads and returns. The share of thread 0 is left to the first
+   *   thread out of work, or to the launching thread once it joins.
+   */
+  void launch_async();
+
+  /*
+   * Method: join_async
+   * --------------------------
+   *   Helps the loop started by launch_async, as thread 0, until it ends.
+   */
+  void join_async();
+
+  // Whether the current thread launched the asynchronous loop running on this pool and did not join it yet
+  bool owns_async() const;
+
+  /*
+   * Method: launch_detached
+   * --------------------------
+   *   Starts loop, whose workers are on workers_array, on the other threads and returns. The launch mutex, locked by
+   *   the caller, and loop are handed over to the pool: the thread executing the last share calls loop->complete(),
+   *   while the pool still runs the loop so the loops it launches nest in it, then deletes loop. The last thread out
+   *   of the loop unlocks launch.
+   *   Needs a pool of several threads.
+   */
+  void launch_detached(AsyncLoopInterface *loop);
+
   friend void adapt::start_workers();
   friend void adapt::stop_workers();
 };
@@ -44,6 +152,22 @@ public:
 // Instantiates the handler on beginning of program. Destroy at program exit.
 extern ThreadHandler thread_handler;
 
+// Id of the current thread and its pool while it runs a loop, -1 and nullptr otherwise
+extern thread_local int current_thread_id ADPT_TLS_INITIAL_EXEC;
+extern thread_local ThreadHandler *current_handler ADPT_TLS_INITIAL_EXEC;
+
+// Pool selected by task_arena::execute on the current thread, nullptr otherwise
+extern thread_local ThreadHandler *selected_handler ADPT_TLS_INITIAL_EXEC;
+
+/*
+ * Function: active_handler
+ * --------------------------
+ *   Pool of the loop the current thread runs, else the one selected by task_arena::execute, else the global one.
+ */
+inline ThreadHandler &active_handler() {
+  return current_handler ? *current_handler : (selected_handler ? *selected_handler : thread_handler);
+}
+
 } // namespace __internal__
 } // namespace adapt
 
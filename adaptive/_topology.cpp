@@ -0,0 +1,183 @@
+#include "_topology.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <limits>
+#include <pthread.h>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace adapt {
+namespace __internal__ {
+
+static const std::string sysfs_cpu = "/sys/devices/system/cpu/cpu";
+
+// Lowest cpu of a sysfs cpu list ("0-3,8,10-11"), or -1 if it cannot be read
+static int first_of_cpu_list(const std::string &path) {
+  std::ifstream file(path);
+  int cpu = -1;
+  if (!(file >> cpu)) return -1;
+  return cpu;
+}
+
+static int read_int(const std::string &path, int default_value) {
+  std::ifstream file(path);
+  int value;
+  return (file >> value) ? value : default_value;
+}
+
+// Lowest cpu sharing the last level cache (L3, or the highest level found) of cpu
+static int cache_domain(const int cpu) {
+  int domain = -1, best_level = 0;
+  for (int index = 0;; index++) {
+    std::ostringstream dir;
+    dir << sysfs_cpu << cpu << "/cache/index" << index << "/";
+    const int level = read_int(dir.str() + "level", -1);
+    if (level < 0) break;
+    if (level >= best_level) {
+      const int shared = first_of_cpu_list(dir.str() + "shared_cpu_list");
+      if (shared >= 0) {
+        domain     = shared;
+        best_level = level;
+      }
+    }
+    if (level >= 3) break;
+  }
+  return domain;
+}
+
+// NUMA node of cpu, from its nodeN entry
+static int node_domain(const int cpu) {
+  std::ostringstream path;
+  path << sysfs_cpu << cpu;
+  DIR *dir = opendir(path.str().c_str());
+  if (!dir) return -1;
+  int node = -1;
+  for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir)) {
+    const std::string name(entry->d_name);
+    if ((name.compare(0, 4, "node") == 0) && (name.size() > 4) && isdigit(name[4])) {
+      node = atoi(name.c_str() + 4);
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+// Capacity of cpu from sysfs: cpu_capacity (arm, recent x86 hybrids), else its maximum frequency, else 0
+static double sysfs_capacity(const int cpu) {
+  std::ostringstream path;
+  path << sysfs_cpu << cpu << "/";
+  const int capacity = read_int(path.str() + "cpu_capacity", -1);
+  if (capacity > 0) return capacity;
+  const int frequency = read_int(path.str() + "cpufreq/cpuinfo_max_freq", -1);
+  return (frequency > 0) ? frequency : 0.0;
+}
+
+// Capacity of cpu measured as the speed of a short dependent integer chain running on it (best of 3 runs)
+static double probe_capacity(const int cpu) {
+  cpu_set_t previous, cpuset;
+  pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous);
+  CPU_ZERO(&cpuset);
+  CPU_SET(cpu, &cpuset);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+
+  double best = std::numeric_limits<double>::max();
+  for (int run = 0; run < 3; run++) {
+    volatile uint64_t sink;
+    uint64_t x       = 88172645463325252ull;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < (1 << 20); i++) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+    }
+    sink = x;
+    (void)sink;
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+  }
+
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous);
+  return 1.0 / best;
+}
+
+size_t Topology::classify(const std::vector<double> &capacity, std::vector<bool> &little) {
+  little.assign(capacity.size(), false);
+  const double biggest = capacity.empty() ? 0.0 : *std::max_element(capacity.begin(), capacity.end());
+  if (biggest <= 0.0) return 1;
+
+  double little_sum = 0.0;
+  size_t num_little = 0;
+  for (size_t t = 0; t < capacity.size(); t++) {
+    if ((capacity[t] > 0.0) && (capacity[t] < 0.8 * biggest)) { // turbo/favored core variations stay big
+      little[t] = true;
+      little_sum += capacity[t];
+      num_little++;
+    }
+  }
+  if (num_little == 0) return 1;
+  return std::max(size_t(std::round(biggest / (little_sum / num_little))), size_t(1));
+}
+
+Topology::Topology() : _num_threads(0), _alpha(1) {}
+
+void Topology::discover(size_t num_threads, bool calibrate, const std::vector<int> &cpus) {
+  const int num_cpus = cpus.empty() ? std::max(std::thread::hardware_concurrency(), 1u) : int(cpus.size());
+  this->_num_threads = num_threads;
+  this->_cpu.resize(num_threads);
+  this->_capacity.assign(num_threads, 0.0);
+  for (int level = 0; level < NUM_LEVELS; level++) this->_domain[level].assign(num_threads, 0);
+  std::vector<int> smt(num_threads, 0);
+
+  for (size_t t = 0; t < num_threads; t++) {
+    const int cpu = cpus.empty() ? int(t % num_cpus) : cpus[t % num_cpus]; // same mapping used to pin threads
+    std::ostringstream topology;
+    topology << sysfs_cpu << cpu << "/topology/";
+    const int package       = read_int(topology.str() + "physical_package_id", 0);
+    const int node          = node_domain(cpu);
+    const int cache         = cache_domain(cpu);
+    this->_cpu[t]           = cpu;
+    if (t >= size_t(num_cpus)) // oversubscribed cpu: already measured
+      this->_capacity[t] = this->_capacity[t - num_cpus];
+    else
+      this->_capacity[t] = calibrate ? probe_capacity(cpu) : sysfs_capacity(cpu);
+    smt[t]                  = first_of_cpu_list(topology.str() + "thread_siblings_list");
+    this->_domain[NODE][t]  = (node >= 0) ? node : package;
+    this->_domain[CACHE][t] = (cache >= 0) ? cache : -(this->_domain[NODE][t] + 1); // whole node if unknown
+  }
+
+  this->_alpha = Topology::classify(this->_capacity, this->_little);
+
+  this->_neighbours.resize(num_threads * num_threads);
+  this->_level_end.resize(num_threads * NUM_LEVELS);
+  for (size_t t = 0; t < num_threads; t++) {
+    // distance: 0 = SMT sibling, 1 = shared cache, 2 = same node, 3 = remote
+    auto distance = [&](const size_t o) {
+      if (this->_domain[CACHE][o] != this->_domain[CACHE][t])
+        return (this->_domain[NODE][o] == this->_domain[NODE][t]) ? 2 : 3;
+      return ((smt[o] >= 0) && (smt[o] == smt[t])) ? 0 : 1;
+    };
+    uint16_t *order = &this->_neighbours[t * num_threads];
+    size_t count    = 0;
+    for (size_t o = 0; o < num_threads; o++)
+      if (o != t) order[count++] = uint16_t(o);
+    std::stable_sort(order, order + count,
+                     [&](const uint16_t a, const uint16_t b) { return distance(a) < distance(b); });
+
+    size_t end = 0;
+    for (int level = 0; level < NUM_LEVELS; level++) {
+      while ((end < count) && (distance(order[end]) <= level + 1)) end++;
+      this->_level_end[t * NUM_LEVELS + level] = uint16_t(end);
+    }
+  }
+}
+
+} // namespace __internal__
+} // namespace adapt
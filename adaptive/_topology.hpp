@@ -0,0 +1,78 @@
+#pragma once
+
+#ifndef _TOPOLOGY_HPP_
+#define _TOPOLOGY_HPP_
+
+#include "_defines.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: Topology
+ * --------------------------
+ *   CPU topology of the scheduler threads, discovered from /sys/devices/system/cpu at startup. For each thread, the
+ *   other threads are sorted by distance: first the ones sharing its last level cache (SMT siblings first), then
+ *   the ones on its NUMA node, then the remote ones. Without sysfs information, every thread is equally distant.
+ *
+ *   It also classifies the cores of asymmetric processors (ARM big.LITTLE, Intel P/E cores) by their capacity, read
+ *   from cpu_capacity, from cpufreq/cpuinfo_max_freq or, if requested, measured by a short calibration probe.
+ */
+class Topology {
+public:
+  enum Level { CACHE = 0, NODE = 1, SYSTEM = 2, NUM_LEVELS = 3 };
+
+private:
+  size_t _num_threads;
+  std::vector<int> _cpu;                // cpu of each thread
+  std::vector<int> _domain[NUM_LEVELS]; // domain id of each thread on each level
+  std::vector<uint16_t> _neighbours;    // other threads of each thread, sorted by distance
+  std::vector<uint16_t> _level_end;     // end of each level on the sorted neighbours of each thread
+  std::vector<double> _capacity;        // relative performance of the core of each thread
+  std::vector<bool> _little;            // whether each thread runs on a LITTLE core
+  size_t _alpha;                        // performance ratio between big and LITTLE cores
+
+public:
+  Topology();
+
+  /*
+   * Method: discover
+   * --------------------------
+   *   Reads the topology of the cpus of num_threads threads, thread t running on cpus[t] (cpu t by default). With
+   *   calibrate, core capacities are measured by running a short probe on each cpu instead of being read from sysfs.
+   */
+  void discover(size_t num_threads, bool calibrate = false, const std::vector<int> &cpus = std::vector<int>());
+
+  /*
+   * Method: classify
+   * --------------------------
+   *   Marks as LITTLE the capacities clearly below the biggest one, and returns the measured alpha: the rounded ratio
+   *   between the biggest capacity and the mean LITTLE capacity (1 without LITTLE cores).
+   */
+  static size_t classify(const std::vector<double> &capacity, std::vector<bool> &little);
+
+  inline size_t num_threads() const { return this->_num_threads; }
+  inline int cpu(size_t thread) const { return this->_cpu[thread]; }
+  inline int domain(size_t thread, Level level) const { return this->_domain[level][thread]; }
+  inline double capacity(size_t thread) const { return this->_capacity[thread]; }
+  inline bool is_little(size_t thread) const { return (thread < this->_num_threads) && this->_little[thread]; }
+  inline size_t alpha() const { return this->_alpha; }
+
+  /*
+   * Method: neighbours
+   * --------------------------
+   *   The num_threads - 1 other threads, closest first. Those sharing the given level with thread are on
+   *   [0, level_end(thread, level)).
+   */
+  inline const uint16_t *neighbours(size_t thread) const { return &this->_neighbours[thread * this->_num_threads]; }
+  inline size_t level_end(size_t thread, Level level) const { return this->_level_end[thread * NUM_LEVELS + level]; }
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
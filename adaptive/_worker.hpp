@@ -4,12 +4,16 @@
 #define _WORKER_HPP_
 
 #include "_defines.hpp"
+#include "_packed_range.hpp"
 #include "atomic_mutex.hpp"
+#include "cancellation_token.hpp"
+#include "policy.hpp"
 
 #include <array>
 #include <atomic>
 #include <cmath>
-#include <vector>
+#include <limits>
+#include <type_traits>
 
 namespace adapt {
 namespace __internal__ // anonymous namespace
@@ -18,76 +22,127 @@ namespace __internal__ // anonymous namespace
 class WorkerInterface {
 public:
   virtual void work() = 0;
+  virtual ~WorkerInterface() {}
 };
 
-template <class Index>
+/*
+ * Struct: CacheLinePad
+ * --------------------------
+ *   Empty member that fills a whole cache line. Members declared after it never share a line with the ones before.
+ */
+struct alignas(ADPT_CACHE_LINE) CacheLinePad {};
+
+/*
+ * Class: Worker
+ * --------------------------
+ *   Fields are grouped by who touches them, each group on its own cache lines:
+ *     - owner-private: read and written only by the thread running the worker;
+ *     - first: written by the owner on every extraction, read by thieves;
+ *     - last, lock, steal bounds: written by thieves on every steal, read by the owner.
+ *   Once the token of the loop is cancelled, extractions fail: owners and thieves leave after their current chunk.
+ *   Cancelled from a position, owners stop once their next chunk starts there and thieves skip steals starting there.
+ *   With indices up to 32 bits, first and last live together in the packed word `range` (see uses_packed_range), and
+ *   the `first` and `last` members become read-only views of it.
+ *   Fields of derived workers start after a padding line, and the class alignment keeps workers of different threads
+ *   on different lines.
+ */
+template <class Index, class Policy = default_policy>
 class Worker : public WorkerInterface {
 protected:
+  typedef uses_packed_range<Index> packed_t;
+  typedef PackedRange<Index> packed_range_t;
+  typedef typename std::conditional<packed_t::value, packed_range_t, NoPackedRange>::type range_t;
+  typedef typename std::conditional<packed_t::value, PackedBound<Index, false>, std::atomic<Index>>::type first_t;
+  typedef typename std::conditional<packed_t::value, PackedBound<Index, true>, std::atomic<Index>>::type last_t;
+
   const Index _id;
   const Index _nthr;
   Index _working_first;
   Index _working_last;
   bool _is_reduction = false;
-  std::vector<Worker *> *_workers_array;
+  WorkerInterface **_workers_array;
+  const cancellation_token *_token;                 // of the loop
+  typename Policy::victim_type _victim;             // victim selector of this thief
+  typename Policy::distribution_type _distribution; // distribution learning from this worker
+  typename Policy::grain_type _grain;               // grain of this owner
+  typename Policy::steal_type _steal;               // steal sizing of this thief
 
 public:
-  std::atomic<Index> first; // first iteration of sub-range
-  std::atomic<Index> last;  // last (+1) iteration of sub-range
-  Index copy_first;         // non-atomic copy of first
-  Index seq_chunk;          // chunk/grain size
-  Index min_steal;          // square root of su-range size
-  Index half_range;         // half of range
-  AtomicMutex lock;         // worker lock
+  Index copy_first; // non-atomic copy of first
+  Index seq_chunk;  // chunk/grain size
+
+  alignas(ADPT_CACHE_LINE) range_t range; // packed [first, last) of sub-range
+  first_t first;                           // first iteration of sub-range
+
+  alignas(ADPT_CACHE_LINE) last_t last; // last (+1) iteration of sub-range
+  AtomicMutex lock;                     // worker lock
+  Index min_steal;                      // square root of su-range size
+  std::atomic<Index> half_range;        // half of range, halved by steal_half thieves
+  std::atomic<uint32_t> grain_cuts;     // grain halvings by reduce_grain_steal thieves, applied by the owner
   bool is_LITTLE;
 
-  Worker(const size_t thr_id, const Index global_first, const Index global_last, std::vector<Worker *> *workers_array) :
-      _id(thr_id), _nthr(get_num_threads()), _workers_array(workers_array) {
-    this->is_LITTLE = IS_LITTLE(_id);
-
-#ifdef DISTRIB_BY_DEMAND // thread 0 starts with entire range
-    this->first = (this->_id == 0) ? global_first : Index(0);
-    this->last  = (this->_id == 0) ? global_last : Index(0);
-#elif DISTRIB_BY_ALPHA // big cores have initial range ALPHA times bigger
-    const size_t alpha = get_alpha();
-    const Index v_nthr = (this->_nthr - num_big_cores) + (num_big_cores * alpha);
-    const Index v_size = (this->is_LITTLE) ? 1 : alpha;
-    Index v_id         = 0;
-    for (Index i = 0; i < _id; i++) v_id += (IS_LITTLE(i) ? 1 : alpha);
-    const Index chunk    = (global_last - global_first) / v_nthr; // size of initial sub-range (integer division)
-    const Index remain   = (global_last - global_first) % v_nthr; // remains of integer division
-    this->first          = chunk * v_id + global_first + MIN(v_id, remain); // first iteration of sub-range
-    this->last           = this->first + (chunk * v_size) + Index((v_id < remain) ? MIN((remain - v_id), v_size) : 0);
-#else                  // divides initial range equally
-    const Index chunk  = (global_last - global_first) / this->_nthr; // size of initial sub-range (integer division)
-    const Index remain = (global_last - global_first) % this->_nthr; // remains of integer division
-    this->first     = chunk * this->_id + global_first + MIN(Index(this->_id), remain); // first iteration of sub-range
-    this->last      = this->first + chunk + static_cast<Index>(this->_id < remain); // last (+1) iteration of sub-range
-#endif
+protected:
+  CacheLinePad _pad;
+
+public:
+  Worker(const size_t thr_id,
+         const Index global_first,
+         const Index global_last,
+         WorkerInterface **workers_array,
+         const Policy &policy = Policy(),
+         const cancellation_token &token = never_cancelled()) :
+      _id(thr_id), _nthr(get_num_threads()), _workers_array(workers_array), _token(&token), _victim(policy.victim),
+      _distribution(policy.distribution), _grain(policy.grain), _steal(policy.steal), grain_cuts(0) {
+    this->is_LITTLE = is_little(thr_id);
+    this->_victim.init(this->_id, this->_nthr);
+
+    Index _first, _last;
+    this->_distribution.range(thr_id, this->_nthr, global_first, global_last, _first, _last);
+    this->init_range(_first, _last, packed_t());
     this->recalc_internal();
   }
 
   virtual ~Worker() {}
 
 protected:
+  void init_range(const Index _first, const Index _last, std::false_type) {
+    this->first = _first;
+    this->last  = _last;
+  }
+
+  void init_range(const Index _first, const Index _last, std::true_type) {
+    this->range.word = packed_range_t::pack(_first, _last);
+    this->first.bind(this->range);
+    this->last.bind(this->range);
+  }
+
   inline void recalc_internal() {
     this->_working_first = this->_working_last = this->copy_first = this->first;
-    const Index range_size = this->last - this->copy_first; // original size of sub-range
-    const size_t grain     = get_grain();
-#ifdef GRAIN_FRACTION
-    this->seq_chunk = MAX(range_size / grain, Index(1));
-#elif GRAIN_LOG
-    this->seq_chunk      = MAX(Index(std::log2(range_size)), Index(1)); // chunk/grain size to serial extraction
-#else
-    this->seq_chunk = grain;
-#endif
-#ifdef GRAIN_SMALLER_LITTLE
-    if (this->is_LITTLE)
-      this->seq_chunk = MAX(this->seq_chunk / get_alpha(), Index(1)); // LITTLE cores have half of grain
-#endif
-    this->half_range = range_size >> 1;
-    this->min_steal  = MAX(Index(std::sqrt(range_size)), Index(1)); // minimal size to steal
+    const Index range_size = this->last - this->copy_first;                 // original size of sub-range
+    this->seq_chunk        = this->_grain.chunk(range_size, this->is_LITTLE); // chunk/grain size to serial extraction
+    this->min_steal        = MAX(Index(std::sqrt(range_size)), Index(1)); // minimal size to steal
+    this->half_range.store(range_size >> 1, std::memory_order_relaxed);
+  }
+
+  /*
+   * Method: chunk_started / chunk_finished
+   * --------------------------
+   *   Policy hooks around the execution of each extracted chunk [_working_first, _working_last).
+   */
+  inline void chunk_started() { this->_grain.start(); }
+
+  inline void chunk_finished() {
+    this->_grain.finish(this->seq_chunk, Index(this->_working_last - this->_working_first));
+    this->_distribution.executed(this->_id, this->_working_first, this->_working_last);
   }
 
+  /*
+   * Method: work_finished
+   * --------------------------
+   *   Policy hooks once the worker finds nothing left to steal.
+   */
+  inline void work_finished() { this->_distribution.finish(this->_id); }
+
   /*
    * Method: extract_seq
    * --------------------------
@@ -99,12 +154,14 @@ protected:
    *   returns : true if it could extract 1 or more iterations
    */
   bool extract_seq() {
-#ifdef EXTRACT_THRESHOLD
-    const Index chunk    = ((this->last - this->_working_last) > (this->seq_chunk << 2)) ? this->seq_chunk : 1;
+    if (this->_token->is_cancelled(this->copy_first)) return false; // next chunk cancelled
+    this->_steal.refresh(*this); // applies what thieves asked of the owner
+    return this->extract_seq(packed_t());
+  }
+
+  bool extract_seq(std::false_type) {
+    const Index chunk    = this->_grain.extract(*this);
     this->_working_first = MIN((this->copy_first + chunk), static_cast<Index>(this->last));
-#else
-    this->_working_first = MIN((this->copy_first + this->seq_chunk), static_cast<Index>(this->last));
-#endif
     if (this->_working_first > this->_working_last) {
       this->first = this->_working_first;
       if (this->_working_first < this->last) {
@@ -124,21 +181,77 @@ protected:
     return (this->_working_first < this->first);
   }
 
+  /*
+   * Method: extract_seq (packed)
+   * --------------------------
+   *   Advances first with a CAS on the packed word, which fails only if a thief changed last meanwhile.
+   */
+  bool extract_seq(std::true_type) {
+    const Index chunk = this->_grain.extract(*this);
+    uint64_t word     = this->range.word;
+    while (true) {
+      const Index _first = packed_range_t::first_of(word);
+      const Index _last  = packed_range_t::last_of(word);
+      if (!(_first < _last)) return false;
+      const Index new_first = MIN(Index(_first + chunk), _last);
+      if (this->range.word.compare_exchange_weak(word, packed_range_t::pack(new_first, _last))) {
+        this->_working_first = _first;
+        this->_working_last = this->copy_first = new_first;
+        return true;
+      }
+    }
+  }
+
+  /*
+   * Method: extract_next
+   * --------------------------
+   *   Replaces the finished sub-range of current thread with the next one given by the distribution policy, if any.
+   *   The lock keeps thieves away while both bounds change.
+   *
+   *   returns : true if it got a new sub-range
+   */
+  bool extract_next() {
+    Index next_first, next_last;
+    if (this->_token->is_cancelled() || !this->_distribution.next(this->_id, next_first, next_last)) return false;
+    this->set_range(next_first, next_last, packed_t());
+    this->recalc_internal();
+    return true;
+  }
+
+  void set_range(const Index next_first, const Index next_last, std::false_type) {
+    this->lock.lock();
+    this->first = std::numeric_limits<Index>::max();
+    this->last  = next_last;
+    this->first = next_first;
+    this->lock.unlock();
+  }
+
+  void set_range(const Index next_first, const Index next_last, std::true_type) { // thieves skip the empty range
+    this->range.word = packed_range_t::pack(next_first, next_last);
+  }
+
   /*
    * Method: extract_par
    * --------------------------
    *   Steals sequential work from a sub-range of another thread.
-   *   The algorithm randomly selects a sub-range from another thread and do the tests:
+   *   The algorithm selects a sub-range from another thread, following the victim selection policy, and do the tests:
    *     - If it can be locked
    *     - If it have a minimal amount of work to be stealed
-   *   The minimal amount is half of the remaining work, and it cannot be lower than sqrt(m),
-   *   where m is the original sub-range size.
+   *   The amount stolen is given by the steal policy (by default, half of the remaining work).
    *
    *   returns : true if it could steal work from someone, false otherwise
    */
-  bool extract_par() {
+  bool extract_par() { return !this->_token->is_cancelled() && this->extract_par(packed_t()); }
+
+  bool extract_par(std::false_type) {
     size_t remaining = this->_nthr - 1;
     size_t i;
+    WorkerInterface **workers = this->_workers_array;
+    auto victim_work          = [workers](const size_t v) -> Index {
+      const Worker &w = *static_cast<Worker *>(workers[v]);
+      const Index f = w.first, l = w.last;
+      return (l > f) ? Index(l - f) : Index(0);
+    };
 
     this->first = std::numeric_limits<Index>::max();
     this->last  = std::numeric_limits<Index>::max();
@@ -146,51 +259,26 @@ protected:
     std::array<bool, ADPT_MAX_THREADS> _visited;
     _visited.fill(false);
     _visited[this->_id] = true;
+    this->_victim.begin();
 
     // While there are sub-ranges that are not inspected yet
     while (remaining) {
-      for (i = rand() % this->_nthr; _visited[i]; i = (i + 1) % this->_nthr)
-        ; // Advances to an unvisited victim/sub-range
-      Worker &victim = *(this->_workers_array->at(i));
-
-#ifdef STEAL_ONLY_FROM_LITTLE
-      if (victim.is_LITTLE && (victim.last > victim.first)) {
-#else
-      if (victim.last > victim.first) {
-#endif
+      i              = this->_victim.next(_visited, victim_work);
+      Worker &victim = *static_cast<Worker *>(this->_workers_array[i]);
+
+      if (this->_steal.allowed(*this, victim) && (victim.last > victim.first)) {
         if (victim.lock.try_lock()) {
-          const Index vic_last = victim.last;
-          Index steal_size;
-#ifdef STEAL_HALF
-          do {
-            steal_size = victim.half_range;
-            victim.half_range >>= 1;
-          } while (victim.first > (vic_last - steal_size) && steal_size);
-#else // STEAL_HALF_REMAINING
-          const Index remain = vic_last - victim.first;
-          steal_size         = (remain > 0) ? MAX(remain >> 1, Index(1)) : 0;
-#endif
-#ifdef STEAL_SMALLER_LITTLE
-          if (is_LITTLE) steal_size /= alpha; // cut steal by half
-#endif
-#ifdef STEAL_THRESHOLD_LITTLE
-          if ((steal_size < victim.min_steal) && is_LITTLE) {
-            victim.lock.unlock();
-            --remaining;
-            _visited[i] = true;
-            continue; // cancel if stealer is LITTLE and steal size is too small
-          }
-#endif
+          const Index vic_last   = victim.last;
+          const Index steal_size = this->_steal.size(*this, victim, vic_last); // 0 cancels the steal
           const Index new_last = vic_last - steal_size;
-          if ((victim.last > new_last) && (victim.first <= new_last)) { // verify overflow
+          if ((victim.last > new_last) && (victim.first <= new_last) && // verify overflow
+              !this->_token->is_cancelled(new_last)) {
             victim.last = new_last;
             if (victim.first > victim.last) {
               /* rollback and abort */
               victim.last = vic_last;
             } else if (steal_size > 0) {
-#ifdef REDUCE_GRAIN_ON_STEAL
-              victim.seq_chunk = MAX(victim.seq_chunk >> 1, Index(1));
-#endif
+              this->_steal.stolen(victim);
               victim.lock.unlock();
               this->last  = vic_last;
               this->first = new_last;
@@ -207,6 +295,54 @@ protected:
     }
     return false;
   }
+
+  /*
+   * Method: extract_par (packed)
+   * --------------------------
+   *   Same as above, but the thief moves the victim's last with a single CAS on its packed word. A failed CAS means the
+   *   victim's owner or another thief got there first, and the victim is inspected again.
+   */
+  bool extract_par(std::true_type) {
+    size_t remaining = this->_nthr - 1;
+    size_t i;
+    WorkerInterface **workers = this->_workers_array;
+    auto victim_work          = [workers](const size_t v) -> Index {
+      const uint64_t word = static_cast<Worker *>(workers[v])->range.word;
+      const Index f = packed_range_t::first_of(word), l = packed_range_t::last_of(word);
+      return (l > f) ? Index(l - f) : Index(0);
+    };
+
+    std::array<bool, ADPT_MAX_THREADS> _visited;
+    _visited.fill(false);
+    _visited[this->_id] = true;
+    this->_victim.begin();
+
+    // While there are sub-ranges that are not inspected yet
+    while (remaining) {
+      i              = this->_victim.next(_visited, victim_work);
+      Worker &victim = *static_cast<Worker *>(this->_workers_array[i]);
+
+      uint64_t word        = victim.range.word;
+      const Index vic_first = packed_range_t::first_of(word);
+      const Index vic_last  = packed_range_t::last_of(word);
+      if (this->_steal.allowed(*this, victim) && (vic_last > vic_first)) {
+        const Index steal_size = this->_steal.size(*this, victim, vic_last); // 0 cancels the steal
+        const Index new_last   = vic_last - steal_size;
+        if ((steal_size > 0) && (vic_last > new_last) && (vic_first <= new_last) && // verify overflow
+            !this->_token->is_cancelled(new_last)) {
+          if (!victim.range.word.compare_exchange_strong(word, packed_range_t::pack(vic_first, new_last)))
+            continue; // sub-range changed meanwhile
+          this->_steal.stolen(victim);
+          this->range.word = packed_range_t::pack(new_last, vic_last);
+          this->recalc_internal();
+          return true;
+        }
+      }
+      --remaining;
+      _visited[i] = true;
+    }
+    return false;
+  }
 }; // namespace __internal__
 
 } // namespace __internal__
@@ -0,0 +1,32 @@
+#include "_worker_arena.hpp"
+
+#include <cstdlib>
+#include <new>
+
+namespace adapt {
+namespace __internal__ {
+
+WorkerArena::WorkerArena() : _storage(nullptr), _slot_size(0), _alignment(ADPT_CACHE_LINE), _num_slots(0) {}
+
+WorkerArena::~WorkerArena() { free(this->_storage); }
+
+void WorkerArena::reserve(size_t num_slots, size_t size, size_t alignment) {
+  alignment = MAX(alignment, size_t(ADPT_CACHE_LINE));
+  if ((num_slots <= this->_num_slots) && (size <= this->_slot_size) && (alignment <= this->_alignment)) return;
+
+  num_slots           = MAX(num_slots, this->_num_slots);
+  alignment           = MAX(alignment, this->_alignment);
+  size                = MAX(size, this->_slot_size);
+  const size_t padded = (size + alignment - 1) & ~(alignment - 1); // slots never share a cache line
+
+  void *storage = nullptr;
+  if (posix_memalign(&storage, alignment, padded * num_slots)) throw std::bad_alloc();
+  free(this->_storage);
+  this->_storage   = static_cast<char *>(storage);
+  this->_slot_size = padded;
+  this->_alignment = alignment;
+  this->_num_slots = num_slots;
+}
+
+} // namespace __internal__
+} // namespace adapt
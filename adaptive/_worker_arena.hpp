@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef _WORKER_ARENA_HPP_
+#define _WORKER_ARENA_HPP_
+
+#include "_defines.hpp"
+
+#include <cstddef>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: WorkerArena
+ * --------------------------
+ *   Persistent storage for the workers of a parallel loop. Each thread owns one slot, aligned and padded to a
+ *   multiple of the cache line. Workers are constructed in-place on the slots and destroyed after the loop, so the
+ *   storage is reused by every loop and only grows when a loop needs a bigger worker than any previous one.
+ */
+class WorkerArena {
+  char *_storage;
+  size_t _slot_size;
+  size_t _alignment;
+  size_t _num_slots;
+
+public:
+  WorkerArena();
+  WorkerArena(const WorkerArena &) = delete;
+  WorkerArena &operator=(const WorkerArena &) = delete;
+  ~WorkerArena();
+
+  /*
+   * Method: reserve
+   * --------------------------
+   *   Ensures there are at least num_slots slots of size bytes aligned to alignment. Must not be called while
+   *   workers are alive on the arena.
+   */
+  void reserve(size_t num_slots, size_t size, size_t alignment);
+
+  inline void *slot(size_t id) const { return this->_storage + id * this->_slot_size; }
+};
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -3,12 +3,33 @@
 #ifndef _ADAPTIVE_HPP_
 #define _ADAPTIVE_HPP_
 
+#include "_async_loop.hpp"
 #include "_parallel_for_worker.hpp"
 #include "_reduction_worker.hpp"
+#include "_scan.hpp"
 #include "_thread_handler.hpp"
+#include "blocked_range.hpp"
+#include "cancellation_token.hpp"
+#include "task_arena.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
 
 namespace adapt {
 
+/*
+ * Function: adapt::this_worker_id
+ * ---------------------------
+ *   Id of the thread running the current loop body, in [0, get_num_threads()) of the pool running the loop; the
+ *   thread launching a loop is 0. Ids of nested loops are the ones of the outer loop.
+ *
+ *   returns : the id, or -1 outside loops
+ */
+inline int this_worker_id() { return __internal__::current_thread_id; }
+
 /*
  * Function: adapt::parallel_for
  * ---------------------------
@@ -16,27 +37,147 @@ namespace adapt {
  *           first : beggining of loop
  *            last : end of loop
  *   local_compute : loop body
+ *           token : stops the loop once cancelled (adapt::cancellation_token), optional
+ *          policy : scheduling policy (adapt::policy)
+ *
+ *   Called from the body of a running loop, the loop is nested: threads done with the outer loop help execute it, and
+ *   the policy is ignored.
  */
+template <class Function, class Index, class Policy>
+void parallel_for(Index first,
+                  Index last,
+                  Function local_compute,
+                  const cancellation_token &token,
+                  const Policy &policy) {
+  using namespace __internal__;
+  using forworker_t         = ForWorker<Index, Function, Policy>;
+  ThreadHandler &handler    = active_handler();
+  const size_t num_threads  = handler.num_threads;
+  WorkerInterface **workers = handler.workers_array.data();
+
+  if (current_thread_id >= 0 || handler.owns_async()) { // nested loop: shares the threads of the running loop
+    NestedFor<Index, Function> nested(first, last, local_compute, num_threads, token);
+    handler.run_nested(nested);
+    return;
+  }
+
+  std::lock_guard<FutexMutex> launch(handler.launch); // loops of other threads on this pool wait
+  policy.distribution.start(num_threads, first, last);
+
+  // Workers are built in-place on the persistent arena: no allocation per loop
+  handler.arena.reserve(num_threads, sizeof(forworker_t), alignof(forworker_t));
+  for (size_t i = 0; i < num_threads; i++)
+    workers[i] = new (handler.arena.slot(i)) forworker_t(i, first, last, workers, local_compute, policy, token);
+
+  // this thread work
+  handler.active = num_threads;
+  handler.work(0);
+  handler.barrier->wait(0);
+
+  for (size_t i = 0; i < num_threads; i++) static_cast<forworker_t *>(workers[i])->~forworker_t();
+}
+
+template <class Function, class Index>
+void parallel_for(Index first, Index last, Function local_compute, const cancellation_token &token) {
+  parallel_for(first, last, local_compute, token, default_policy());
+}
+
+template <class Function, class Index, class Policy>
+void parallel_for(Index first, Index last, Function local_compute, const Policy &policy) {
+  parallel_for(first, last, local_compute, __internal__::never_cancelled(), policy);
+}
+
 template <class Function, class Index>
 void parallel_for(Index first, Index last, Function local_compute) {
+  parallel_for(first, last, local_compute, default_policy());
+}
+
+/*
+ * Class: loop_handle
+ * ---------------------------
+ *   Loop running on the threads of a pool while the thread that launched it goes on (see parallel_for_async). The
+ *   pool stays taken until wait(): other threads launching loops on it wait, and the loops the launching thread
+ *   starts on it meanwhile (parallel_for, parallel_reduce, task_group::wait) are nested in the asynchronous one.
+ *   wait() is called by the destructor if needed.
+ */
+class loop_handle {
+  __internal__::ThreadHandler *_handler;
+  std::unique_lock<__internal__::FutexMutex> _launch;
+  std::unique_ptr<__internal__::AsyncLoopInterface> _loop;
+
+public:
+  // Handle of a loop already over
+  loop_handle() : _handler(nullptr) {}
+  loop_handle(__internal__::ThreadHandler &handler,
+              std::unique_lock<__internal__::FutexMutex> &&launch,
+              std::unique_ptr<__internal__::AsyncLoopInterface> &&loop) :
+      _handler(&handler), _launch(std::move(launch)), _loop(std::move(loop)) {}
+  loop_handle(loop_handle &&) = default;
+  loop_handle &operator=(loop_handle &&other) {
+    this->wait();
+    this->_handler = other._handler;
+    this->_launch  = std::move(other._launch);
+    this->_loop    = std::move(other._loop);
+    return *this;
+  }
+  ~loop_handle() { this->wait(); }
+
+  // true once every iteration has been executed; wait() then returns without executing any
+  bool ready() const { return !this->_loop || this->_handler->active.load(std::memory_order_acquire) == 0; }
+
+  /*
+   * Method: wait
+   * ---------------------------
+   *   Joins the loop as one of its threads until it ends, then releases the pool. Must be called by the thread that
+   *   launched the loop.
+   */
+  void wait() {
+    if (!this->_loop) return;
+    this->_handler->join_async();
+    this->_loop.reset();
+    this->_launch.unlock();
+  }
+};
+
+/*
+ * Function: adapt::parallel_for_async
+ * ---------------------------
+ *
+ *           first : beggining of loop
+ *            last : end of loop
+ *   local_compute : loop body, kept by the loop until it ends
+ *          policy : scheduling policy (adapt::policy)
+ *
+ *   Launches the loop on the threads of the active pool but the current one, and returns at once: the first pool
+ *   thread out of work takes the share of the launching thread, which joins the loop at wait(). Serial work of the
+ *   launching thread thus overlaps the loop. Called from the body of a running loop, or by a thread that did not
+ *   wait for the asynchronous loop it launched on the pool, the loop is nested and over on return, as parallel_for.
+ *
+ *   returns : handle to wait for the end of the loop
+ *
+ *     adapt::loop_handle loop = adapt::parallel_for_async(0, n, body);
+ *     read_next_batch();
+ *     loop.wait();
+ */
+template <class Function, class Index, class Policy>
+loop_handle parallel_for_async(Index first, Index last, Function local_compute, const Policy &policy) {
   using namespace __internal__;
-  using forworker_t        = ForWorker<Index, Function>;
-  using worker_t           = Worker<Index>;
-  const size_t num_threads = get_num_threads();
-  std::vector<worker_t *> workers(num_threads, nullptr); // Data for workers
-
-  for (size_t i = 0; i < num_threads; i++) {
-    forworker_t *worker          = new forworker_t(i, first, last, &workers, local_compute);
-    workers[i]                   = static_cast<worker_t *>(worker);
-    thread_handler.workers_array[i] = static_cast<WorkerInterface *>(worker);
+  ThreadHandler &handler = active_handler();
+  if (current_thread_id >= 0 || handler.owns_async()) {
+    parallel_for(first, last, local_compute, policy);
+    return loop_handle();
   }
 
-  // this thread work
-  thread_handler.work(0);
-  thread_handler.barrier.wait();
+  std::unique_lock<FutexMutex> launch(handler.launch); // until wait()
+  std::unique_ptr<AsyncLoopInterface> loop(
+    new AsyncFor<Index, Function, Policy>(handler, first, last, std::move(local_compute), policy));
+  handler.launch_async();
+  return loop_handle(handler, std::move(launch), std::move(loop));
+}
 
-  for (size_t i = 0; i < num_threads; i++) delete workers[i];
-  workers.clear();
+template <class Function, class Index>
+loop_handle parallel_for_async(Index first, Index last, Function local_compute) {
+  return parallel_for_async(first, last, std::move(local_compute), default_policy());
 }
 
 /*
@@ -48,37 +189,317 @@ void parallel_for(Index first, Index last, Function local_compute) {
  *        identity : intial value of reduction
  *   local_compute : loop body
  *       reduction : reduction function
+ *          policy : scheduling policy (adapt::policy)
+ *
+ *   May be nested in the body of a running loop, as parallel_for.
  */
-template <class Function, class Index, class Reduction, class Value>
+template <class Function, class Index, class Reduction, class Value, class Policy>
 Value parallel_reduce(const Index first,
                       const Index last,
-                      const Value identity,
+                      const Value &identity,
                       const Function &local_compute,
-                      const Reduction &reduction) {
+                      const Reduction &reduction,
+                      const Policy &policy) {
   using namespace __internal__;
-  using redworker_t        = ReductionWorker<Index, Function, Value, Reduction>;
-  using worker_t           = Worker<Index>;
-  const size_t num_threads = get_num_threads();
-  std::vector<worker_t *> workers(num_threads, nullptr); // Data for workers
-
-  for (size_t i = 0; i < num_threads; i++) {
-    redworker_t *worker          = new redworker_t(i, first, last, identity, &workers, local_compute, reduction);
-    workers[i]                   = static_cast<worker_t *>(worker);
-    thread_handler.workers_array[i] = static_cast<WorkerInterface *>(worker);
+  using redworker_t         = ReductionWorker<Index, Function, Value, Reduction, Policy>;
+  ThreadHandler &handler    = active_handler();
+  const size_t num_threads  = handler.num_threads;
+  WorkerInterface **workers = handler.workers_array.data();
+
+  if (current_thread_id >= 0 || handler.owns_async()) { // nested loop: shares the threads of the running loop
+    NestedReduce<Index, Function, Value, Reduction> nested(first, last, identity, local_compute, reduction,
+                                                           num_threads);
+    handler.run_nested(nested);
+    return std::move(nested.reduction_value);
   }
 
+  std::lock_guard<FutexMutex> launch(handler.launch); // loops of other threads on this pool wait
+  policy.distribution.start(num_threads, first, last);
+
+  // Workers are built in-place on the persistent arena: no allocation per loop
+  handler.arena.reserve(num_threads, sizeof(redworker_t), alignof(redworker_t));
+  for (size_t i = 0; i < num_threads; i++)
+    workers[i] = new (handler.arena.slot(i))
+      redworker_t(i, first, last, identity, workers, local_compute, reduction, policy);
+
   // this thread work
-  thread_handler.work(0);
-  thread_handler.barrier.wait();
+  handler.active = num_threads;
+  handler.work(0);
+  handler.barrier->wait(0);
+
+  Value reduction_value = std::move(static_cast<redworker_t *>(workers[0])->reduction_value);
+
+  for (size_t i = 0; i < num_threads; i++) static_cast<redworker_t *>(workers[i])->~redworker_t();
+
+  return reduction_value;
+}
+
+template <class Function, class Index, class Reduction, class Value>
+Value parallel_reduce(const Index first,
+                      const Index last,
+                      const Value &identity,
+                      const Function &local_compute,
+                      const Reduction &reduction) {
+  return parallel_reduce(first, last, identity, local_compute, reduction, default_policy());
+}
+
+/*
+ * Function: adapt::parallel_scan
+ * ---------------------------
+ *
+ *      first : beggining of loop
+ *       last : end of loop
+ *   identity : identity of combine
+ *       scan : scan body, prefix = scan(first, last, prefix, is_final): returns prefix combined with [first, last)
+ *              and, if is_final, writes the scan of [first, last) starting from prefix
+ *    combine : joins the values of two adjacent sub-ranges, left one first
+ *     policy : scheduling policy (adapt::policy)
+ *
+ *   Each thread scans the chunks it extracts for good (is_final) once the prefix at their start is known; sub-ranges
+ *   stolen before that are only summed and scanned again after the loop, so the extra work is on stolen iterations
+ *   only. scan must accept both is_final values on any sub-range, and combine be associative.
+ *
+ *   returns : identity combined with the whole loop
+ */
+template <class Function, class Index, class Combine, class Value, class Policy>
+Value parallel_scan(const Index first,
+                    const Index last,
+                    const Value identity,
+                    const Function &scan,
+                    const Combine &combine,
+                    const Policy &policy) {
+  using namespace __internal__;
+  typedef Scan<Index, Value, Function, Combine> scan_t;
+  scan_t state(first, last, identity, scan, combine, active_handler().num_threads);
+  parallel_for(
+    first, last, [&state](const Index b, const Index e) { state.chunk(size_t(current_thread_id), b, e); }, policy);
+
+  std::vector<typename scan_t::Rescan> rescans;
+  const Value total = state.resolve(rescans);
+  parallel_for(
+    size_t(0), rescans.size(),
+    [&state, &rescans](const size_t b, const size_t e) {
+      for (size_t i = b; i < e; i++) state.rescan(rescans[i]);
+    },
+    default_policy());
+  return total;
+}
 
-  Value reduction_value = static_cast<redworker_t *>(workers[0])->reduction_value;
+template <class Function, class Index, class Combine, class Value>
+Value parallel_scan(
+  const Index first, const Index last, const Value identity, const Function &scan, const Combine &combine) {
+  return parallel_scan(first, last, identity, scan, combine, scan_policy());
+}
+
+namespace __internal__ // anonymous namespace
+{
+
+// Loop over [0, n) scheduled with indices of type Index; body(first, last) gets size_t bounds
+template <class Index, class Function, class Policy>
+void parallel_for_as(const size_t n,
+                     const Function &body,
+                     const Policy &policy,
+                     const cancellation_token &token) {
+  parallel_for(
+    Index(0), Index(n), [&body](const Index first, const Index last) { body(size_t(first), size_t(last)); }, token,
+    policy);
+}
+
+template <class Index, class Function, class Reduction, class Value, class Policy>
+Value parallel_reduce_as(const size_t n, const Value identity, const Function &body, const Reduction &reduction,
+                         const Policy &policy) {
+  return parallel_reduce(
+    Index(0), Index(n), identity,
+    [&body](const Index first, const Index last, const Value value) {
+      return body(size_t(first), size_t(last), value);
+    },
+    reduction, policy);
+}
+
+/*
+ * Function: parallel_for_n
+ * ---------------------------
+ *   Loop over [0, n), for callers whose count does not come with an index type of its own (iterators, tiles). Up to
+ *   2^32 iterations are scheduled with 32-bit indices, which steal without locking.
+ */
+template <class Function, class Policy>
+void parallel_for_n(const size_t n,
+                    const Function &body,
+                    const Policy &policy,
+                    const cancellation_token &token = never_cancelled()) {
+  if (n <= UINT32_MAX)
+    parallel_for_as<uint32_t>(n, body, policy, token);
+  else
+    parallel_for_as<size_t>(n, body, policy, token);
+}
+
+template <class Function, class Reduction, class Value, class Policy>
+Value parallel_reduce_n(const size_t n, const Value identity, const Function &body, const Reduction &reduction,
+                        const Policy &policy) {
+  if (n <= UINT32_MAX) return parallel_reduce_as<uint32_t>(n, identity, body, reduction, policy);
+  return parallel_reduce_as<size_t>(n, identity, body, reduction, policy);
+}
+
+template <class Function, class Combine, class Value, class Policy>
+Value parallel_scan_n(const size_t n, const Value identity, const Function &scan, const Combine &combine,
+                      const Policy &policy) {
+  if (n <= UINT32_MAX) return parallel_scan(uint32_t(0), uint32_t(n), identity, scan, combine, policy);
+  return parallel_scan(size_t(0), n, identity, scan, combine, policy);
+}
+
+// Calls body on every tile of range (blocked_range2d or blocked_range3d)
+template <class Range, class Function, class Policy>
+void parallel_for_tiles(const Range &range, const Function &body, const Policy &policy) {
+  parallel_for_n(
+    range.num_tiles(),
+    [&range, &body](const size_t first, const size_t last) {
+      for (size_t t = first; t < last; t++) body(range.tile(t));
+    },
+    policy);
+}
+
+template <class Range, class Function, class Reduction, class Value, class Policy>
+Value parallel_reduce_tiles(const Range &range, const Value identity, const Function &body, const Reduction &reduction,
+                            const Policy &policy) {
+  return parallel_reduce_n(
+    range.num_tiles(), identity,
+    [&range, &body](const size_t first, const size_t last, Value value) {
+      for (size_t t = first; t < last; t++) value = body(range.tile(t), value);
+      return value;
+    },
+    reduction, policy);
+}
 
-  for (size_t i = 0; i < num_threads; i++) delete workers[i];
-  workers.clear();
+} // namespace __internal__
 
+/*
+ * Function: adapt::parallel_deterministic_reduce
+ * ---------------------------
+ *
+ *           first : beggining of loop
+ *            last : end of loop
+ *        identity : intial value of reduction
+ *   local_compute : loop body, as in parallel_reduce
+ *       reduction : reduction function
+ *          policy : scheduling policy (adapt::policy)
+ *           block : iterations per block; 0 cuts the loop in DETERMINISTIC_BLOCKS blocks
+ *
+ *   Same result, bit for bit, whatever the number of threads and the steals: the loop is cut in blocks that depend on
+ *   its range only, each block is reduced from identity on its own, and the partial values of the blocks are combined
+ *   in index order once the loop is over. Costs a body call per block and a sequential pass over the partial values.
+ */
+const size_t DETERMINISTIC_BLOCKS = 4096;
+
+template <class Function, class Index, class Reduction, class Value, class Policy>
+Value parallel_deterministic_reduce(const Index first,
+                                    const Index last,
+                                    const Value &identity,
+                                    const Function &local_compute,
+                                    const Reduction &reduction,
+                                    const Policy &policy,
+                                    const size_t block = 0) {
+  const size_t size       = (last > first) ? size_t(last - first) : 0;
+  const size_t span       = block ? block : MAX((size + DETERMINISTIC_BLOCKS - 1) / DETERMINISTIC_BLOCKS, size_t(1));
+  const size_t num_blocks = (size + span - 1) / span;
+
+  std::vector<Value> partial(num_blocks, identity);
+  __internal__::parallel_for_n(
+    num_blocks,
+    [&](const size_t b, const size_t e) {
+      for (size_t i = b; i < e; i++) {
+        const Index block_first = first + Index(i * span);
+        const Index block_last  = (i + 1 == num_blocks) ? last : Index(block_first + Index(span));
+        __internal__::accumulate(local_compute, block_first, block_last, partial[i], identity, reduction);
+      }
+    },
+    policy);
+
+  Value reduction_value = identity;
+  for (Value &value : partial) __internal__::combine(reduction, reduction_value, std::move(value));
   return reduction_value;
 }
 
+template <class Function, class Index, class Reduction, class Value>
+Value parallel_deterministic_reduce(const Index first,
+                                    const Index last,
+                                    const Value &identity,
+                                    const Function &local_compute,
+                                    const Reduction &reduction) {
+  return parallel_deterministic_reduce(first, last, identity, local_compute, reduction, default_policy());
+}
+
+/*
+ * Function: adapt::parallel_for (2D and 3D)
+ * ---------------------------
+ *
+ *           range : blocked_range2d or blocked_range3d
+ *   local_compute : tile body, called with each tile of range
+ *          policy : scheduling policy (adapt::policy), applied to the tiles in Morton order
+ */
+template <class Function, class Index, class Policy>
+void parallel_for(const blocked_range2d<Index> &range, Function local_compute, const Policy &policy) {
+  __internal__::parallel_for_tiles(range, local_compute, policy);
+}
+
+template <class Function, class Index>
+void parallel_for(const blocked_range2d<Index> &range, Function local_compute) {
+  __internal__::parallel_for_tiles(range, local_compute, default_policy());
+}
+
+template <class Function, class Index, class Policy>
+void parallel_for(const blocked_range3d<Index> &range, Function local_compute, const Policy &policy) {
+  __internal__::parallel_for_tiles(range, local_compute, policy);
+}
+
+template <class Function, class Index>
+void parallel_for(const blocked_range3d<Index> &range, Function local_compute) {
+  __internal__::parallel_for_tiles(range, local_compute, default_policy());
+}
+
+/*
+ * Function: adapt::parallel_reduce (2D and 3D)
+ * ---------------------------
+ *
+ *           range : blocked_range2d or blocked_range3d
+ *        identity : intial value of reduction
+ *   local_compute : tile body, value = local_compute(tile, value)
+ *       reduction : reduction function
+ *          policy : scheduling policy (adapt::policy), applied to the tiles in Morton order
+ */
+template <class Function, class Index, class Reduction, class Value, class Policy>
+Value parallel_reduce(const blocked_range2d<Index> &range,
+                      const Value identity,
+                      const Function &local_compute,
+                      const Reduction &reduction,
+                      const Policy &policy) {
+  return __internal__::parallel_reduce_tiles(range, identity, local_compute, reduction, policy);
+}
+
+template <class Function, class Index, class Reduction, class Value>
+Value parallel_reduce(const blocked_range2d<Index> &range,
+                      const Value identity,
+                      const Function &local_compute,
+                      const Reduction &reduction) {
+  return __internal__::parallel_reduce_tiles(range, identity, local_compute, reduction, default_policy());
+}
+
+template <class Function, class Index, class Reduction, class Value, class Policy>
+Value parallel_reduce(const blocked_range3d<Index> &range,
+                      const Value identity,
+                      const Function &local_compute,
+                      const Reduction &reduction,
+                      const Policy &policy) {
+  return __internal__::parallel_reduce_tiles(range, identity, local_compute, reduction, policy);
+}
+
+template <class Function, class Index, class Reduction, class Value>
+Value parallel_reduce(const blocked_range3d<Index> &range,
+                      const Value identity,
+                      const Function &local_compute,
+                      const Reduction &reduction) {
+  return __internal__::parallel_reduce_tiles(range, identity, local_compute, reduction, default_policy());
+}
+
 }; // namespace adapt
 
 #endif
\ No newline at end of file
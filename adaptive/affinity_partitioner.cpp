@@ -0,0 +1,64 @@
+#include "affinity_partitioner.hpp"
+
+#include <algorithm>
+
+namespace adapt {
+
+affinity_partitioner::affinity_partitioner() : _nthr(0), _recording(0), _replay(false) {}
+
+void affinity_partitioner::start(size_t nthr, int64_t first, int64_t last) {
+  bool valid = (nthr == this->_nthr);
+
+  std::vector<Piece> all;
+  for (size_t t = 0; valid && t < nthr; t++) {
+    const Slot &slot = this->_slots[t];
+    valid            = !slot.overflow;
+    all.insert(all.end(), slot.pieces[this->_recording].begin(),
+               slot.pieces[this->_recording].begin() + slot.count[this->_recording]);
+  }
+
+  // Recorded pieces must tile the new loop range exactly: no iteration executed twice or left behind
+  if (valid) {
+    std::sort(all.begin(), all.end(), [](const Piece &a, const Piece &b) { return a.first < b.first; });
+    int64_t next = first;
+    for (size_t i = 0; valid && i < all.size(); i++) {
+      valid = (all[i].first == next);
+      next  = all[i].last;
+    }
+    valid = valid && (next == last);
+  }
+
+  if (nthr != this->_nthr) {
+    this->_slots.resize(nthr);
+    this->_nthr = nthr;
+  }
+  this->_replay = valid;
+  if (valid) this->_recording = 1 - this->_recording;
+  for (size_t t = 0; t < nthr; t++) {
+    this->_slots[t].count[this->_recording] = 0;
+    this->_slots[t].overflow                = false;
+    if (!valid) this->_slots[t].count[1 - this->_recording] = 0;
+  }
+}
+
+bool affinity_partitioner::piece(size_t id, size_t i, int64_t &first, int64_t &last) const {
+  const Slot &slot = this->_slots[id];
+  if (!this->_replay || i >= slot.count[1 - this->_recording]) return false;
+  first = slot.pieces[1 - this->_recording][i].first;
+  last  = slot.pieces[1 - this->_recording][i].last;
+  return true;
+}
+
+void affinity_partitioner::executed(size_t id, int64_t first, int64_t last) {
+  Slot &slot    = this->_slots[id];
+  size_t &count = slot.count[this->_recording];
+  auto &pieces  = slot.pieces[this->_recording];
+  if (count > 0 && pieces[count - 1].last == first) // consecutive chunks of the same sub-range
+    pieces[count - 1].last = last;
+  else if (count < MAX_PIECES)
+    pieces[count++] = {first, last};
+  else
+    slot.overflow = true;
+}
+
+} // namespace adapt
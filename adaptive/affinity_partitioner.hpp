@@ -0,0 +1,81 @@
+#pragma once
+
+#ifndef _AFFINITY_PARTITIONER_HPP_
+#define _AFFINITY_PARTITIONER_HPP_
+
+#include "_defines.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace adapt {
+
+/*
+ * Class: affinity_partitioner
+ * ---------------------------
+ *   Remembers which pieces of a loop each thread executed, own sub-range and stolen pieces alike, so the next run of
+ *   the same loop (through affinity_distribution) gives every thread back the iterations it already has in cache.
+ *   Owned by the caller and kept alive across the runs of one loop; a loop with a different range or thread count
+ *   starts over with an even distribution.
+ */
+class affinity_partitioner {
+public:
+  static const size_t MAX_PIECES = 32; // per thread; a thread executing more pieces disables the replay once
+
+  affinity_partitioner();
+  affinity_partitioner(const affinity_partitioner &) = delete;
+  affinity_partitioner &operator=(const affinity_partitioner &) = delete;
+
+  /*
+   * Method: start
+   * ---------------------------
+   *   Called once per loop, before the workers are built. The pieces recorded by the last run become the ones replayed
+   *   by this run, if they cover exactly [first, last) on nthr threads.
+   */
+  void start(size_t nthr, int64_t first, int64_t last);
+
+  /*
+   * Method: replaying
+   * ---------------------------
+   *   returns : true if this run replays the pieces of the last one
+   */
+  bool replaying() const { return this->_replay; }
+
+  /*
+   * Method: piece
+   * ---------------------------
+   *   Piece i of thread id on the last run.
+   *
+   *   returns : false if thread id executed less than i + 1 pieces
+   */
+  bool piece(size_t id, size_t i, int64_t &first, int64_t &last) const;
+
+  /*
+   * Method: executed
+   * ---------------------------
+   *   Records [first, last) as executed by thread id on this run. Only thread id writes its own pieces.
+   */
+  void executed(size_t id, int64_t first, int64_t last);
+
+private:
+  struct Piece {
+    int64_t first, last;
+  };
+
+  struct Slot {
+    std::array<Piece, MAX_PIECES> pieces[2];
+    size_t count[2];
+    bool overflow;
+    char _pad[ADPT_CACHE_LINE]; // threads record on their own slots
+  };
+
+  std::vector<Slot> _slots;
+  size_t _nthr;
+  size_t _recording; // pieces[_recording] is recorded, pieces[1 - _recording] replayed
+  bool _replay;
+};
+
+} // namespace adapt
+
+#endif
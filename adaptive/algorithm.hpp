@@ -0,0 +1,484 @@
+#pragma once
+
+#ifndef _ALGORITHM_HPP_
+#define _ALGORITHM_HPP_
+
+#include "adaptive.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace adapt {
+
+/*
+ * Parallel algorithms
+ * ---------------------------
+ *   Standard algorithm shapes over random-access iterators, scheduled as adaptive loops over the positions of the
+ *   sequence. Each accepts an optional scheduling policy (adapt::policy) as last argument; by default, the grain is
+ *   tuned online (auto_grain), since element-wise bodies are usually too cheap for single-iteration chunks.
+ */
+
+typedef policy<default_victim, default_distribution, auto_grain> algorithm_policy;
+typedef policy<default_victim, demand_distribution, auto_grain> algorithm_scan_policy; // as scan_policy
+
+/*
+ * Function: adapt::for_each
+ * ---------------------------
+ *   Calls function on every element of [first, last).
+ */
+template <class Iterator, class Function, class Policy>
+void for_each(const Iterator first, const Iterator last, const Function &function, const Policy &policy) {
+  __internal__::parallel_for_n(
+    size_t(last - first),
+    [first, &function](const size_t b, const size_t e) {
+      for (Iterator it = first + b; it != first + e; ++it) function(*it);
+    },
+    policy);
+}
+
+template <class Iterator, class Function>
+void for_each(const Iterator first, const Iterator last, const Function &function) {
+  adapt::for_each(first, last, function, algorithm_policy());
+}
+
+/*
+ * Function: adapt::transform
+ * ---------------------------
+ *   Writes operation(x) for every element x of [first, last) on the same position of the sequence starting on result.
+ *
+ *   returns : end of the written sequence
+ */
+template <class Iterator, class OutputIterator, class Operation, class Policy>
+OutputIterator transform(const Iterator first, const Iterator last, const OutputIterator result,
+                         const Operation &operation, const Policy &policy) {
+  __internal__::parallel_for_n(
+    size_t(last - first),
+    [first, result, &operation](const size_t b, const size_t e) {
+      OutputIterator out = result + b;
+      for (Iterator it = first + b; it != first + e; ++it, ++out) *out = operation(*it);
+    },
+    policy);
+  return result + (last - first);
+}
+
+template <class Iterator, class OutputIterator, class Operation>
+OutputIterator transform(const Iterator first, const Iterator last, const OutputIterator result,
+                         const Operation &operation) {
+  return adapt::transform(first, last, result, operation, algorithm_policy());
+}
+
+/*
+ * Function: adapt::transform_reduce
+ * ---------------------------
+ *   Reduces init and transform(x) for every element x of [first, last) with reduce, which must be associative and
+ *   commutative. Unlike parallel_reduce, init is used once: threads that found no element yet hold no value.
+ */
+template <class Iterator, class Value, class Reduce, class Transform, class Policy>
+Value transform_reduce(const Iterator first, const Iterator last, const Value init, const Reduce &reduce,
+                       const Transform &transform, const Policy &policy) {
+  typedef std::pair<bool, Value> partial_t; // (holds a value, value)
+  const partial_t partial = __internal__::parallel_reduce_n(
+    size_t(last - first), partial_t(false, init),
+    [first, &reduce, &transform](const size_t b, const size_t e, partial_t value) {
+      for (Iterator it = first + b; it != first + e; ++it) {
+        value.second = value.first ? reduce(value.second, transform(*it)) : Value(transform(*it));
+        value.first  = true;
+      }
+      return value;
+    },
+    [&reduce](const partial_t &left, const partial_t &right) -> partial_t {
+      if (!left.first) return right;
+      if (!right.first) return left;
+      return partial_t(true, reduce(left.second, right.second));
+    },
+    policy);
+  return partial.first ? Value(reduce(init, partial.second)) : init;
+}
+
+template <class Iterator, class Value, class Reduce, class Transform>
+Value transform_reduce(const Iterator first, const Iterator last, const Value init, const Reduce &reduce,
+                       const Transform &transform) {
+  return adapt::transform_reduce(first, last, init, reduce, transform, algorithm_policy());
+}
+
+/*
+ * Function: adapt::count_if
+ * ---------------------------
+ *   returns : number of elements of [first, last) satisfying predicate
+ */
+template <class Iterator, class Predicate, class Policy>
+typename std::iterator_traits<Iterator>::difference_type
+count_if(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  typedef typename std::iterator_traits<Iterator>::difference_type difference_t;
+  return __internal__::parallel_reduce_n(
+    size_t(last - first), difference_t(0),
+    [first, &predicate](const size_t b, const size_t e, difference_t count) {
+      for (Iterator it = first + b; it != first + e; ++it) count += predicate(*it) ? 1 : 0;
+      return count;
+    },
+    [](const difference_t left, const difference_t right) { return left + right; }, policy);
+}
+
+template <class Iterator, class Predicate>
+typename std::iterator_traits<Iterator>::difference_type
+count_if(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::count_if(first, last, predicate, algorithm_policy());
+}
+
+/*
+ * Function: adapt::find_if
+ * ---------------------------
+ *   The position of each match found cancels the loop from there on (cancellation_token::cancel_from): owners stop
+ *   extracting and thieves stop stealing the chunks past the lowest match, and elements after it are not tested.
+ *
+ *   returns : first element of [first, last) satisfying predicate, or last
+ */
+template <class Iterator, class Predicate, class Policy>
+Iterator find_if(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  const size_t n = size_t(last - first);
+  cancellation_token token; // cancelled from the lowest matching position found so far
+  __internal__::parallel_for_n(
+    n,
+    [first, &predicate, &token](const size_t b, const size_t e) {
+      for (size_t i = b; i < e && !token.is_cancelled(i); i++) {
+        if (!predicate(first[i])) continue;
+        token.cancel_from(i);
+        return;
+      }
+    },
+    policy, token);
+  return first + MIN(size_t(token.cancelled_from()), n);
+}
+
+template <class Iterator, class Predicate>
+Iterator find_if(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::find_if(first, last, predicate, algorithm_policy());
+}
+
+/*
+ * Function: adapt::parallel_find
+ * ---------------------------
+ *   Stops at the first match found, through a cancellation_token: threads leave after the element they test, and
+ *   nothing more is extracted or stolen. Unlike find_if, the element found is any one satisfying predicate, not
+ *   necessarily the first.
+ *
+ *   returns : an element of [first, last) satisfying predicate, or last
+ */
+template <class Iterator, class Predicate, class Policy>
+Iterator parallel_find(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  const size_t n = size_t(last - first);
+  std::atomic<size_t> found(n); // position of the match that cancelled the loop
+  cancellation_token token;
+  __internal__::parallel_for_n(
+    n,
+    [first, n, &predicate, &found, &token](const size_t b, const size_t e) {
+      for (size_t i = b; i < e && !token.is_cancelled(); i++) {
+        if (!predicate(first[i])) continue;
+        size_t none = n;
+        found.compare_exchange_strong(none, i, std::memory_order_relaxed);
+        token.cancel();
+        return;
+      }
+    },
+    policy, token);
+  return first + found.load();
+}
+
+template <class Iterator, class Predicate>
+Iterator parallel_find(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::parallel_find(first, last, predicate, algorithm_policy());
+}
+
+/*
+ * Function: adapt::any_of / all_of / none_of
+ * ---------------------------
+ *   Run as parallel_find, stopping at the first element that decides the answer.
+ */
+template <class Iterator, class Predicate, class Policy>
+bool any_of(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  return adapt::parallel_find(first, last, predicate, policy) != last;
+}
+
+template <class Iterator, class Predicate>
+bool any_of(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::any_of(first, last, predicate, algorithm_policy());
+}
+
+template <class Iterator, class Predicate, class Policy>
+bool none_of(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  return !adapt::any_of(first, last, predicate, policy);
+}
+
+template <class Iterator, class Predicate>
+bool none_of(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::none_of(first, last, predicate, algorithm_policy());
+}
+
+template <class Iterator, class Predicate, class Policy>
+bool all_of(const Iterator first, const Iterator last, const Predicate &predicate, const Policy &policy) {
+  typedef typename std::iterator_traits<Iterator>::reference reference_t;
+  return !adapt::any_of(first, last, [&predicate](reference_t x) { return !predicate(x); }, policy);
+}
+
+template <class Iterator, class Predicate>
+bool all_of(const Iterator first, const Iterator last, const Predicate &predicate) {
+  return adapt::all_of(first, last, predicate, algorithm_policy());
+}
+
+/*
+ * Function: adapt::inclusive_scan
+ * ---------------------------
+ *   Writes x0, op(x0, x1), op(op(x0, x1), x2), ... for the elements of [first, last) on the sequence starting on
+ *   result, which may be first. op must be associative. Runs as parallel_scan.
+ *
+ *   returns : end of the written sequence
+ */
+template <class Iterator, class OutputIterator, class Operation, class Policy>
+OutputIterator inclusive_scan(const Iterator first,
+                              const Iterator last,
+                              const OutputIterator result,
+                              const Operation &operation,
+                              const Policy &policy) {
+  typedef typename std::iterator_traits<Iterator>::value_type value_t;
+  typedef std::pair<bool, value_t> partial_t; // (holds a value, value)
+  if (first == last) return result;
+  __internal__::parallel_scan_n(
+    size_t(last - first), partial_t(false, *first),
+    [first, result, &operation](const size_t b, const size_t e, partial_t prefix, const bool is_final) {
+      for (size_t i = b; i < e; i++) {
+        prefix = partial_t(true, prefix.first ? value_t(operation(prefix.second, first[i])) : value_t(first[i]));
+        if (is_final) result[i] = prefix.second;
+      }
+      return prefix;
+    },
+    [&operation](const partial_t &left, const partial_t &right) -> partial_t {
+      if (!left.first) return right;
+      if (!right.first) return left;
+      return partial_t(true, operation(left.second, right.second));
+    },
+    policy);
+  return result + (last - first);
+}
+
+template <class Iterator, class OutputIterator, class Operation>
+OutputIterator
+inclusive_scan(const Iterator first, const Iterator last, const OutputIterator result, const Operation &operation) {
+  return adapt::inclusive_scan(first, last, result, operation, algorithm_scan_policy());
+}
+
+/*
+ * Function: adapt::exclusive_scan
+ * ---------------------------
+ *   Writes init, op(init, x0), op(op(init, x0), x1), ... for the elements of [first, last) on the sequence starting on
+ *   result, which may be first. op must be associative. Runs as parallel_scan.
+ *
+ *   returns : end of the written sequence
+ */
+template <class Iterator, class OutputIterator, class Value, class Operation, class Policy>
+OutputIterator exclusive_scan(const Iterator first,
+                              const Iterator last,
+                              const OutputIterator result,
+                              const Value init,
+                              const Operation &operation,
+                              const Policy &policy) {
+  typedef std::pair<bool, Value> partial_t; // (holds a value, value)
+  __internal__::parallel_scan_n(
+    size_t(last - first), partial_t(false, init),
+    [first, result, init, &operation](const size_t b, const size_t e, partial_t prefix, const bool is_final) {
+      if (is_final && !prefix.first) prefix = partial_t(true, init); // beginning of the sequence
+      for (size_t i = b; i < e; i++) {
+        const Value x = first[i]; // read before writing: result may be first
+        if (is_final) result[i] = prefix.second;
+        prefix = partial_t(true, prefix.first ? Value(operation(prefix.second, x)) : x);
+      }
+      return prefix;
+    },
+    [&operation](const partial_t &left, const partial_t &right) -> partial_t {
+      if (!left.first) return right;
+      if (!right.first) return left;
+      return partial_t(true, operation(left.second, right.second));
+    },
+    policy);
+  return result + (last - first);
+}
+
+template <class Iterator, class OutputIterator, class Value, class Operation>
+OutputIterator exclusive_scan(const Iterator first,
+                              const Iterator last,
+                              const OutputIterator result,
+                              const Value init,
+                              const Operation &operation) {
+  return adapt::exclusive_scan(first, last, result, init, operation, algorithm_scan_policy());
+}
+
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Function: co_rank
+ * ---------------------------
+ *   Merge path search: number of elements of a, of size na, among the first k elements of the stable merge of a and b
+ *   (sizes na and nb). Ties take elements of a first.
+ */
+template <class Iterator1, class Iterator2, class Compare>
+size_t co_rank(const size_t k, const Iterator1 a, const size_t na, const Iterator2 b, const size_t nb,
+               const Compare &compare) {
+  size_t low = (k > nb) ? k - nb : 0, high = MIN(k, na);
+  while (low < high) {
+    const size_t i = low + (high - low) / 2;
+    if (!compare(b[k - i - 1], a[i])) // a[i] comes before b[k - i - 1]: takes more of a
+      low = i + 1;
+    else
+      high = i;
+  }
+  return low;
+}
+
+/*
+ * Function: merge_range
+ * ---------------------------
+ *   Writes positions [first, last) of the stable merge of a and b on result, moving the elements if move is set.
+ */
+template <class Iterator1, class Iterator2, class OutputIterator, class Compare>
+void merge_range(const size_t first, const size_t last, const Iterator1 a, const size_t na, const Iterator2 b,
+                 const size_t nb, const OutputIterator result, const Compare &compare, const bool move) {
+  const size_t ia = co_rank(first, a, na, b, nb, compare), ja = co_rank(last, a, na, b, nb, compare);
+  const size_t ib = first - ia, jb = last - ja;
+  if (move)
+    std::merge(std::make_move_iterator(a + ia), std::make_move_iterator(a + ja), std::make_move_iterator(b + ib),
+               std::make_move_iterator(b + jb), result + first, compare);
+  else
+    std::merge(a + ia, a + ja, b + ib, b + jb, result + first, compare);
+}
+
+/*
+ * Function: merge_pass
+ * ---------------------------
+ *   Merges the pairs of adjacent sorted runs of width elements of [source, source + n) into destination. The loop runs
+ *   over the output positions, so threads balance the pass by stealing pieces of any merge.
+ */
+template <class Iterator1, class Iterator2, class Compare, class Policy>
+void merge_pass(const Iterator1 source, const Iterator2 destination, const size_t n, const size_t width,
+                const Compare &compare, const Policy &policy) {
+  parallel_for_n(
+    n,
+    [source, destination, n, width, &compare](const size_t b, const size_t e) {
+      for (size_t pair = b / (2 * width); pair * 2 * width < e; pair++) {
+        const size_t low = pair * 2 * width, middle = MIN(low + width, n), high = MIN(low + 2 * width, n);
+        merge_range(MAX(b, low) - low, MIN(e, high) - low, source + low, middle - low, source + middle, high - middle,
+                    destination + low, compare, true);
+      }
+    },
+    policy);
+}
+
+} // namespace __internal__
+
+/*
+ * Function: adapt::parallel_merge
+ * ---------------------------
+ *   Merges the sorted ranges [first1, last1) and [first2, last2) on the sequence starting on result, stably. The loop
+ *   runs over the output positions: each chunk finds its inputs by a binary search along the merge path, so chunks
+ *   are extracted and stolen as in any other loop.
+ *
+ *   returns : end of the written sequence
+ */
+template <class Iterator1, class Iterator2, class OutputIterator, class Compare, class Policy>
+OutputIterator parallel_merge(const Iterator1 first1,
+                              const Iterator1 last1,
+                              const Iterator2 first2,
+                              const Iterator2 last2,
+                              const OutputIterator result,
+                              const Compare &compare,
+                              const Policy &policy) {
+  const size_t n1 = size_t(last1 - first1), n2 = size_t(last2 - first2);
+  __internal__::parallel_for_n(
+    n1 + n2,
+    [first1, n1, first2, n2, result, &compare](const size_t b, const size_t e) {
+      __internal__::merge_range(b, e, first1, n1, first2, n2, result, compare, false);
+    },
+    policy);
+  return result + (n1 + n2);
+}
+
+template <class Iterator1, class Iterator2, class OutputIterator, class Compare>
+OutputIterator parallel_merge(const Iterator1 first1,
+                              const Iterator1 last1,
+                              const Iterator2 first2,
+                              const Iterator2 last2,
+                              const OutputIterator result,
+                              const Compare &compare) {
+  return adapt::parallel_merge(first1, last1, first2, last2, result, compare, algorithm_policy());
+}
+
+template <class Iterator1, class Iterator2, class OutputIterator>
+OutputIterator parallel_merge(const Iterator1 first1,
+                              const Iterator1 last1,
+                              const Iterator2 first2,
+                              const Iterator2 last2,
+                              const OutputIterator result) {
+  typedef typename std::iterator_traits<Iterator1>::value_type value_t;
+  return adapt::parallel_merge(first1, last1, first2, last2, result, std::less<value_t>(), algorithm_policy());
+}
+
+/*
+ * Function: adapt::parallel_sort
+ * ---------------------------
+ *   Sorts [first, last), not stably. Blocks of the sequence are sorted by a loop over the blocks, then merged pairwise
+ *   by passes over the whole sequence (parallel_merge's merge path), alternating with a buffer of the same size. Every
+ *   step is a single adaptive loop balanced by stealing; there is no fork tree.
+ */
+template <class Iterator, class Compare, class Policy>
+void parallel_sort(const Iterator first, const Iterator last, const Compare &compare, const Policy &policy) {
+  typedef typename std::iterator_traits<Iterator>::value_type value_t;
+  const size_t n     = size_t(last - first);
+  const size_t block = MAX(n / (8 * get_num_threads()), size_t(2048));
+  if (n <= block) {
+    std::sort(first, last, compare);
+    return;
+  }
+
+  __internal__::parallel_for_n(
+    (n + block - 1) / block,
+    [first, n, block, &compare](const size_t b, const size_t e) {
+      for (size_t i = b; i < e; i++) std::sort(first + i * block, first + MIN((i + 1) * block, n), compare);
+    },
+    policy);
+
+  std::vector<value_t> buffer(n);
+  bool in_buffer = false; // where the sorted runs are
+  for (size_t width = block; width < n; width *= 2, in_buffer = !in_buffer) {
+    if (in_buffer)
+      __internal__::merge_pass(buffer.begin(), first, n, width, compare, policy);
+    else
+      __internal__::merge_pass(first, buffer.begin(), n, width, compare, policy);
+  }
+  if (in_buffer) {
+    __internal__::parallel_for_n(
+      n,
+      [first, &buffer](const size_t b, const size_t e) {
+        std::move(buffer.begin() + b, buffer.begin() + e, first + b);
+      },
+      policy);
+  }
+}
+
+template <class Iterator, class Compare>
+void parallel_sort(const Iterator first, const Iterator last, const Compare &compare) {
+  adapt::parallel_sort(first, last, compare, algorithm_policy());
+}
+
+template <class Iterator>
+void parallel_sort(const Iterator first, const Iterator last) {
+  typedef typename std::iterator_traits<Iterator>::value_type value_t;
+  adapt::parallel_sort(first, last, std::less<value_t>(), algorithm_policy());
+}
+
+} // namespace adapt
+
+#endif
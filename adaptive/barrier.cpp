@@ -0,0 +1,154 @@
+#include "barrier.hpp"
+
+#include "_futex.hpp"
+#include "_topology.hpp"
+
+#include <map>
+#include <new>
+
+namespace adapt {
+namespace __internal__ {
+
+void BarrierFlag::signal() {
+  this->value++;
+  if (this->sleepers > 0) futex_wake_all(this->value);
+}
+
+void BarrierFlag::wait_for(const uint32_t target, const uint64_t spin_ns) {
+  auto reached = [this, target]() { return int32_t(this->value - target) >= 0; };
+  if (spin_until(reached, spin_ns)) return;
+
+  this->sleepers++;
+  while (true) {
+    const uint32_t current = this->value; // read before the check: a later signal changes it
+    if (int32_t(current - target) >= 0) break;
+    futex_wait(this->value, current);
+  }
+  this->sleepers--;
+}
+
+} // namespace __internal__
+
+const size_t CombiningBarrier::NO_PARENT;
+const size_t CombiningBarrier::MAX_DEPTH;
+
+CombiningBarrier::CombiningBarrier() : _num_nodes(0), _spin_ns(HybridBarrier::DEFAULT_SPIN_NS) {}
+
+void CombiningBarrier::build(size_t _participants) {
+  std::vector<size_t> items(_participants); // thread standing for each item of the current level
+  std::vector<size_t> parents;              // group of each item on the next level
+  std::vector<size_t> expected, node_parent;
+  for (size_t t = 0; t < _participants; t++) items[t] = t;
+
+  this->_leaf.assign(_participants, NO_PARENT);
+  std::vector<size_t> item_nodes; // node of each item of the current level (empty on the thread level)
+  size_t level = 0;
+  do {
+    std::map<long, size_t> groups;
+    std::vector<size_t> next_items;
+    parents.assign(items.size(), 0);
+    for (size_t i = 0; i < items.size(); i++) {
+      const long key = this->group(level, items[i]);
+      auto found     = groups.find(key);
+      if (found == groups.end()) {
+        found = groups.insert(std::make_pair(key, next_items.size())).first;
+        next_items.push_back(items[i]);
+      }
+      parents[i] = found->second;
+    }
+    level++;
+    if (groups.size() == items.size() && !item_nodes.empty()) continue; // groups of one: skips the level
+
+    const size_t first_node = expected.size();
+    expected.resize(first_node + next_items.size(), 0);
+    node_parent.resize(first_node + next_items.size(), NO_PARENT);
+    for (size_t i = 0; i < items.size(); i++) {
+      expected[first_node + parents[i]]++;
+      if (item_nodes.empty())
+        this->_leaf[items[i]] = first_node + parents[i];
+      else
+        node_parent[item_nodes[i]] = first_node + parents[i];
+    }
+    item_nodes.resize(next_items.size());
+    for (size_t n = 0; n < next_items.size(); n++) item_nodes[n] = first_node + n;
+    items = next_items;
+  } while (items.size() > 1);
+
+  this->_num_nodes = expected.size();
+  this->_nodes.reserve(this->_num_nodes, sizeof(Node), alignof(Node));
+  for (size_t n = 0; n < this->_num_nodes; n++) {
+    Node *node     = new (this->_nodes.slot(n)) Node();
+    node->count    = 0;
+    node->expected = expected[n];
+    node->parent   = node_parent[n];
+  }
+}
+
+void CombiningBarrier::wait(size_t id) {
+  size_t path[MAX_DEPTH]; // nodes this thread arrived last on
+  size_t depth = 0;
+
+  for (size_t n = this->_leaf[id]; n != NO_PARENT;) {
+    Node &node              = this->node(n);
+    const uint32_t released = node.release.value; // read before arriving: the release of this round comes after
+    if (node.count.fetch_add(1) + 1 < node.expected) {
+      node.release.wait_for(released + 1, this->_spin_ns);
+      break;
+    }
+    node.count    = 0; // nobody arrives again before the release
+    path[depth++] = n;
+    n             = node.parent;
+  }
+
+  while (depth > 0) this->node(path[--depth]).release.signal();
+}
+
+TreeBarrier::TreeBarrier(size_t _arity) : _arity(MAX(_arity, size_t(2))) {}
+
+long TreeBarrier::group(size_t level, size_t thread) const {
+  size_t span = this->_arity;
+  for (size_t l = 0; l < level; l++) span *= this->_arity;
+  return long(thread / span);
+}
+
+TopologyBarrier::TopologyBarrier(const __internal__::Topology &_topology) : _topology(_topology) {}
+
+long TopologyBarrier::group(size_t level, size_t thread) const {
+  if (this->_leaf.size() != this->_topology.num_threads()) return 0;
+  if (level == 0) return this->_topology.domain(thread, __internal__::Topology::CACHE);
+  if (level == 1) return this->_topology.domain(thread, __internal__::Topology::NODE);
+  return 0;
+}
+
+DisseminationBarrier::DisseminationBarrier() :
+    _participants(0), _rounds(0), _spin_ns(HybridBarrier::DEFAULT_SPIN_NS) {}
+
+void DisseminationBarrier::set_participants(size_t _participants) {
+  this->_participants = _participants;
+  for (this->_rounds = 0; (size_t(1) << this->_rounds) < _participants; this->_rounds++)
+    ;
+  this->_slots.reserve(_participants, sizeof(Slot), alignof(Slot));
+  for (size_t id = 0; id < _participants; id++) {
+    Slot *slot    = new (this->_slots.slot(id)) Slot();
+    slot->episode = 0;
+  }
+}
+
+void DisseminationBarrier::wait(size_t id) {
+  Slot &self             = this->slot(id);
+  const uint32_t episode = ++self.episode;
+  for (size_t r = 0; r < this->_rounds; r++) {
+    this->slot((id + (size_t(1) << r)) % this->_participants).flags[r].signal();
+    self.flags[r].wait_for(episode, this->_spin_ns); // signals of later episodes only add up
+  }
+}
+
+Barrier *make_barrier(const std::string &name, const __internal__::Topology &topology) {
+  if (name == "central") return new CentralBarrier();
+  if (name == "tree") return new TreeBarrier();
+  if (name == "dissemination") return new DisseminationBarrier();
+  if (name == "topology") return new TopologyBarrier(topology);
+  return nullptr;
+}
+
+} // namespace adapt
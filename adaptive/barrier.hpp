@@ -0,0 +1,185 @@
+#pragma once
+
+#ifndef _BARRIER_HPP_
+#define _BARRIER_HPP_
+
+#include "_defines.hpp"
+#include "_worker_arena.hpp"
+#include "hybrid_barrier.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace adapt {
+
+/*
+ * Class: Barrier
+ * ---------------------------
+ *   Barrier among a fixed set of participants, each passing its own id in [0, participants) to wait(). Waiting
+ *   threads spin for a bounded time (see HybridBarrier) and then sleep. The scheduler uses the algorithm named by
+ *   ADAPT_BARRIER (see make_barrier).
+ */
+class Barrier {
+public:
+  virtual ~Barrier() {}
+  virtual void set_participants(size_t _participants) = 0;
+  virtual void set_spin(uint64_t _spin_ns)            = 0;
+  virtual void wait(size_t id)                         = 0;
+};
+
+/*
+ * Class: CentralBarrier
+ * ---------------------------
+ *   Every thread arrives on a single counter (HybridBarrier). Fastest on few cores.
+ */
+class CentralBarrier : public Barrier {
+  HybridBarrier _barrier;
+
+public:
+  void set_participants(size_t _participants) override { this->_barrier.set_participants(_participants); }
+  void set_spin(uint64_t _spin_ns) override { this->_barrier.set_spin(_spin_ns); }
+  void wait(size_t) override { this->_barrier.wait(); }
+};
+
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Struct: BarrierFlag
+ * ---------------------------
+ *   Counter on its own cache line, signaled by one thread and waited on by others.
+ */
+struct alignas(ADPT_CACHE_LINE) BarrierFlag {
+  std::atomic<uint32_t> value;
+  std::atomic<uint32_t> sleepers;
+
+  BarrierFlag() : value(0), sleepers(0) {}
+  void signal();
+
+  /*
+   * Method: wait_for
+   * ---------------------------
+   *   Waits until value reaches target (modulo 2^32), spinning for spin_ns and then sleeping.
+   */
+  void wait_for(uint32_t target, uint64_t spin_ns);
+};
+
+} // namespace __internal__
+
+/*
+ * Class: CombiningBarrier
+ * ---------------------------
+ *   Threads arrive on small groups; the last one of each group arrives on the group's parent, up to the root. The
+ *   last thread at the root releases the groups it went through, and each released thread releases the groups below
+ *   it, so no cache line is shared by more than a group. Derived classes choose the groups.
+ */
+class CombiningBarrier : public Barrier {
+protected:
+  static const size_t NO_PARENT = ~size_t(0);
+  static const size_t MAX_DEPTH = 16;
+
+  struct alignas(ADPT_CACHE_LINE) Node {
+    std::atomic<uint32_t> count; // arrivals of the current round
+    uint32_t expected;           // arrivals that complete a round
+    size_t parent;
+    __internal__::BarrierFlag release;
+  };
+
+  __internal__::WorkerArena _nodes;
+  std::vector<size_t> _leaf; // node each thread arrives on
+  size_t _num_nodes;
+  std::atomic<uint64_t> _spin_ns;
+
+  inline Node &node(size_t n) const { return *static_cast<Node *>(this->_nodes.slot(n)); }
+
+  /*
+   * Method: group
+   * ---------------------------
+   *   Key of the group of thread on the given level: threads with the same key share a node. A thread stands for its
+   *   whole group on the next level. Must eventually give the same key to every thread.
+   */
+  virtual long group(size_t level, size_t thread) const = 0;
+
+  void build(size_t _participants);
+
+public:
+  CombiningBarrier();
+  void set_spin(uint64_t _spin_ns) override { this->_spin_ns = _spin_ns; }
+  void wait(size_t id) override;
+};
+
+/*
+ * Class: TreeBarrier
+ * ---------------------------
+ *   Combining tree of the given arity over the thread ids.
+ */
+class TreeBarrier : public CombiningBarrier {
+  size_t _arity;
+
+protected:
+  long group(size_t level, size_t thread) const override;
+
+public:
+  TreeBarrier(size_t _arity = 4);
+  void set_participants(size_t _participants) override { this->build(_participants); }
+};
+
+/*
+ * Class: TopologyBarrier
+ * ---------------------------
+ *   Threads sharing a last level cache synchronize first, then the caches of each NUMA node, then the nodes. Falls
+ *   back to a single group if the topology does not describe the participants.
+ */
+class TopologyBarrier : public CombiningBarrier {
+  const __internal__::Topology &_topology;
+
+protected:
+  long group(size_t level, size_t thread) const override;
+
+public:
+  TopologyBarrier(const __internal__::Topology &_topology);
+  void set_participants(size_t _participants) override { this->build(_participants); }
+};
+
+/*
+ * Class: DisseminationBarrier
+ * ---------------------------
+ *   On round r, thread i signals thread (i + 2^r) mod n and waits for thread (i - 2^r) mod n. Every thread is done
+ *   after ceil(log2 n) rounds, without any shared counter.
+ */
+class DisseminationBarrier : public Barrier {
+  static const size_t MAX_ROUNDS = 16;
+
+  struct alignas(ADPT_CACHE_LINE) Slot {
+    __internal__::BarrierFlag flags[MAX_ROUNDS]; // signals received on each round
+    uint32_t episode;                            // barriers passed by the owner thread
+  };
+
+  __internal__::WorkerArena _slots;
+  size_t _participants;
+  size_t _rounds;
+  std::atomic<uint64_t> _spin_ns;
+
+  inline Slot &slot(size_t id) const { return *static_cast<Slot *>(this->_slots.slot(id)); }
+
+public:
+  DisseminationBarrier();
+  void set_participants(size_t _participants) override;
+  void set_spin(uint64_t _spin_ns) override { this->_spin_ns = _spin_ns; }
+  void wait(size_t id) override;
+};
+
+/*
+ * Function: make_barrier
+ * ---------------------------
+ *   Barrier algorithm by name: "central" (default), "tree", "dissemination" or "topology".
+ *
+ *   returns : a new barrier, or nullptr if the name is unknown
+ */
+Barrier *make_barrier(const std::string &name, const __internal__::Topology &topology);
+
+} // namespace adapt
+
+#endif
@@ -0,0 +1,157 @@
+#pragma once
+
+#ifndef _BLOCKED_RANGE_HPP_
+#define _BLOCKED_RANGE_HPP_
+
+#include "_defines.hpp"
+
+#include <cstddef>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Function: morton_tile
+ * ---------------------------
+ *   Coordinates of the index-th tile of a grid of count[0] x ... x count[D-1] tiles, in Morton (Z) order. The grid is
+ *   walked as a tree of 2^D children per level, skipping the ones outside the grid, so indices stay dense and every
+ *   aligned block of the tree is a contiguous interval of indices: any sub-range of tiles is a compact group of blocks.
+ *
+ *   index : position of the tile in Morton order, below count[0] * ... * count[D-1]
+ *   count : number of tiles on each dimension, most significant first
+ *   coord : coordinates of the tile
+ */
+template <size_t D>
+void morton_tile(size_t index, const size_t (&count)[D], size_t (&coord)[D]) {
+  size_t side = 1; // side of the blocks of the current level
+  for (size_t d = 0; d < D; d++) {
+    coord[d] = 0;
+    while (side < count[d]) side <<= 1;
+  }
+  while (side > 1) {
+    side >>= 1;
+    for (size_t child = 0; child < (size_t(1) << D); child++) {
+      size_t inside = 1; // tiles of the child block inside the grid
+      for (size_t d = 0; d < D; d++) {
+        const size_t low = coord[d] + ((child >> (D - 1 - d)) & 1) * side;
+        inside *= (low < count[d]) ? MIN(side, count[d] - low) : 0;
+      }
+      if (index < inside) {
+        for (size_t d = 0; d < D; d++) coord[d] += ((child >> (D - 1 - d)) & 1) * side;
+        break;
+      }
+      index -= inside;
+    }
+  }
+}
+
+} // namespace __internal__
+
+/*
+ * Class: blocked_range
+ * ---------------------------
+ *   Interval [begin, end) of one dimension of a blocked_range2d or blocked_range3d, cut in tiles of grain iterations.
+ */
+template <class Index>
+class blocked_range {
+  Index _begin, _end;
+  size_t _grain;
+
+public:
+  blocked_range(const Index begin, const Index end, const size_t grain = 1) :
+      _begin(begin), _end(end), _grain(MAX(grain, size_t(1))) {}
+
+  Index begin() const { return this->_begin; }
+  Index end() const { return this->_end; }
+  size_t grain() const { return this->_grain; }
+  size_t size() const { return (this->_end > this->_begin) ? size_t(this->_end - this->_begin) : 0; }
+  bool empty() const { return this->size() == 0; }
+
+  size_t num_tiles() const { return (this->size() + this->_grain - 1) / this->_grain; }
+
+  // t-th tile of the interval
+  blocked_range tile(const size_t t) const {
+    const Index first = this->_begin + Index(t * this->_grain);
+    return blocked_range(first, Index(first + MIN(Index(this->_grain), Index(this->_end - first))), this->_grain);
+  }
+};
+
+/*
+ * Class: blocked_range2d
+ * ---------------------------
+ *   Rows x cols grid, cut in tiles of row_grain x col_grain iterations. A parallel_for over it calls the body once per
+ *   tile; the tiles are scheduled in Morton order, so the chunks each thread extracts and the pieces thieves steal are
+ *   groups of neighbour tiles instead of strips of rows.
+ *
+ *     adapt::parallel_for(adapt::blocked_range2d<int>(0, n, 32, 0, m, 32), [&](const adapt::blocked_range2d<int> &r) {
+ *       for (int i = r.rows().begin(); i < r.rows().end(); i++)
+ *         for (int j = r.cols().begin(); j < r.cols().end(); j++) c[i][j] = a[i][j] + b[i][j];
+ *     });
+ */
+template <class Index>
+class blocked_range2d {
+  blocked_range<Index> _rows, _cols;
+
+public:
+  blocked_range2d(const Index row_begin, const Index row_end, const size_t row_grain, const Index col_begin,
+                  const Index col_end, const size_t col_grain) :
+      _rows(row_begin, row_end, row_grain), _cols(col_begin, col_end, col_grain) {}
+  blocked_range2d(const blocked_range<Index> &rows, const blocked_range<Index> &cols) : _rows(rows), _cols(cols) {}
+
+  const blocked_range<Index> &rows() const { return this->_rows; }
+  const blocked_range<Index> &cols() const { return this->_cols; }
+  bool empty() const { return this->_rows.empty() || this->_cols.empty(); }
+
+  size_t num_tiles() const { return this->empty() ? 0 : this->_rows.num_tiles() * this->_cols.num_tiles(); }
+
+  // index-th tile in Morton order
+  blocked_range2d tile(const size_t index) const {
+    const size_t count[2] = {this->_rows.num_tiles(), this->_cols.num_tiles()};
+    size_t coord[2];
+    __internal__::morton_tile(index, count, coord);
+    return blocked_range2d(this->_rows.tile(coord[0]), this->_cols.tile(coord[1]));
+  }
+};
+
+/*
+ * Class: blocked_range3d
+ * ---------------------------
+ *   Pages x rows x cols grid, cut in tiles as blocked_range2d and scheduled in 3D Morton order.
+ */
+template <class Index>
+class blocked_range3d {
+  blocked_range<Index> _pages, _rows, _cols;
+
+public:
+  blocked_range3d(const Index page_begin, const Index page_end, const size_t page_grain, const Index row_begin,
+                  const Index row_end, const size_t row_grain, const Index col_begin, const Index col_end,
+                  const size_t col_grain) :
+      _pages(page_begin, page_end, page_grain),
+      _rows(row_begin, row_end, row_grain),
+      _cols(col_begin, col_end, col_grain) {}
+  blocked_range3d(const blocked_range<Index> &pages, const blocked_range<Index> &rows,
+                  const blocked_range<Index> &cols) :
+      _pages(pages), _rows(rows), _cols(cols) {}
+
+  const blocked_range<Index> &pages() const { return this->_pages; }
+  const blocked_range<Index> &rows() const { return this->_rows; }
+  const blocked_range<Index> &cols() const { return this->_cols; }
+  bool empty() const { return this->_pages.empty() || this->_rows.empty() || this->_cols.empty(); }
+
+  size_t num_tiles() const {
+    return this->empty() ? 0 : this->_pages.num_tiles() * this->_rows.num_tiles() * this->_cols.num_tiles();
+  }
+
+  // index-th tile in Morton order
+  blocked_range3d tile(const size_t index) const {
+    const size_t count[3] = {this->_pages.num_tiles(), this->_rows.num_tiles(), this->_cols.num_tiles()};
+    size_t coord[3];
+    __internal__::morton_tile(index, count, coord);
+    return blocked_range3d(this->_pages.tile(coord[0]), this->_rows.tile(coord[1]), this->_cols.tile(coord[2]));
+  }
+};
+
+} // namespace adapt
+
+#endif
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef _CANCELLATION_TOKEN_HPP_
+#define _CANCELLATION_TOKEN_HPP_
+
+#include <atomic>
+#include <climits>
+
+namespace adapt {
+
+/*
+ * Class: cancellation_token
+ * ---------------------------
+ *   Stops the loops launched with it. Once cancel() is called, from a loop body or from any other thread, owners
+ *   extract no more chunks and thieves find nothing to steal: every thread leaves the loop after the chunk it is
+ *   executing, and the loop returns with the remaining iterations not executed. A token stays cancelled until reset().
+ *
+ *     adapt::cancellation_token token;
+ *     adapt::parallel_for(0, n, [&](const int b, const int e) {
+ *       for (int i = b; i < e; i++) if (v[i] == key) { found = i; token.cancel(); }
+ *     }, token);
+ *
+ *   cancel_from(position) only cancels the iterations from position on, lowered by later calls: chunks starting
+ *   there are neither extracted nor stolen, while the iterations before it go on (first match searches).
+ */
+class cancellation_token {
+  std::atomic<long long> _from; // first cancelled iteration: LLONG_MIN once cancelled, LLONG_MAX if not
+
+public:
+  cancellation_token() : _from(LLONG_MAX) {}
+  cancellation_token(const cancellation_token &) = delete;
+  cancellation_token &operator=(const cancellation_token &) = delete;
+
+  void cancel() { this->_from.store(LLONG_MIN, std::memory_order_relaxed); }
+  void reset() { this->_from.store(LLONG_MAX, std::memory_order_relaxed); }
+  bool is_cancelled() const { return this->_from.load(std::memory_order_relaxed) == LLONG_MIN; }
+
+  template <class Index>
+  void cancel_from(const Index position) {
+    long long from = this->_from.load(std::memory_order_relaxed);
+    while (static_cast<long long>(position) < from &&
+           !this->_from.compare_exchange_weak(from, static_cast<long long>(position), std::memory_order_relaxed)) {}
+  }
+
+  // Whether iteration position is cancelled, by cancel() or cancel_from()
+  template <class Index>
+  bool is_cancelled(const Index position) const {
+    return static_cast<long long>(position) >= this->_from.load(std::memory_order_relaxed);
+  }
+
+  // Lowest position given to cancel_from() since the last reset(), LLONG_MAX if none
+  long long cancelled_from() const { return this->_from.load(std::memory_order_relaxed); }
+};
+
+namespace __internal__ // anonymous namespace
+{
+
+// Token of the loops launched without one
+inline const cancellation_token &never_cancelled() {
+  static const cancellation_token token;
+  return token;
+}
+
+} // namespace __internal__
+} // namespace adapt
+
+#endif
@@ -0,0 +1,220 @@
+#pragma once
+
+#ifndef _DISTRIBUTION_HPP_
+#define _DISTRIBUTION_HPP_
+
+#include "_defines.hpp"
+#include "_loop_history.hpp"
+#include "affinity_partitioner.hpp"
+
+#include <cstdint>
+
+namespace adapt {
+
+/*
+ * Initial distribution policies
+ * ---------------------------
+ *   An initial distribution gives each worker its sub-range when the loop starts:
+ *
+ *     range(id, nthr, global_first, global_last, first, last)
+ *
+ *   sets [first, last) of worker id among nthr workers. Sub-ranges must not overlap and must cover the whole loop.
+ *
+ *   A distribution is also told how the loop went, so it can learn from previous runs:
+ *
+ *     start(nthr, global_first, global_last)  once per loop, before the workers are built
+ *     executed(id, first, last)               on the copy of worker id, after it executes [first, last)
+ *     next(id, first, last)                   on the copy of worker id, when its sub-range is over; returning true
+ *                                             gives it [first, last) before it tries to steal
+ *     finish(id)                              on the copy of worker id, when it runs out of work
+ */
+
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Class: stateless_distribution
+ * ---------------------------
+ *   Empty hooks, for distributions that do not learn.
+ */
+struct stateless_distribution {
+  template <class Index>
+  void start(const size_t, const Index, const Index) const {}
+  template <class Index>
+  void executed(const size_t, const Index, const Index) {}
+  template <class Index>
+  bool next(const size_t, Index &, Index &) {
+    return false;
+  }
+  void finish(const size_t) {}
+};
+
+} // namespace __internal__
+
+/*
+ * Class: even_distribution
+ * ---------------------------
+ *   Divides the loop range equally among threads. Default policy.
+ */
+struct even_distribution : __internal__::stateless_distribution {
+  template <class Index>
+  void range(const size_t id, const size_t nthr, const Index global_first, const Index global_last, Index &first,
+             Index &last) const {
+    const Index chunk  = (global_last - global_first) / Index(nthr); // size of initial sub-range (integer division)
+    const Index remain = (global_last - global_first) % Index(nthr); // remains of integer division
+    first              = chunk * Index(id) + global_first + MIN(Index(id), remain); // first iteration of sub-range
+    last               = first + chunk + static_cast<Index>(Index(id) < remain);   // last (+1) iteration of sub-range
+  }
+};
+
+/*
+ * Class: demand_distribution
+ * ---------------------------
+ *   Thread 0 starts with the entire range, the others get work by stealing.
+ */
+struct demand_distribution : __internal__::stateless_distribution {
+  template <class Index>
+  void range(const size_t id, const size_t, const Index global_first, const Index global_last, Index &first,
+             Index &last) const {
+    first = (id == 0) ? global_first : Index(0);
+    last  = (id == 0) ? global_last : Index(0);
+  }
+};
+
+/*
+ * Class: alpha_distribution
+ * ---------------------------
+ *   Big cores start with sub-ranges ALPHA times bigger than the ones of LITTLE cores.
+ */
+struct alpha_distribution : __internal__::stateless_distribution {
+  template <class Index>
+  void range(const size_t id, const size_t nthr, const Index global_first, const Index global_last, Index &first,
+             Index &last) const {
+    const size_t alpha = __internal__::get_alpha();
+    size_t v_nthr = 0, v_id = 0; // virtual threads: each big core counts as ALPHA LITTLE ones
+    for (size_t i = 0; i < nthr; i++) {
+      if (i == id) v_id = v_nthr;
+      v_nthr += __internal__::is_little(i) ? 1 : alpha;
+    }
+    const Index v_size = __internal__::is_little(id) ? Index(1) : Index(alpha);
+    const Index chunk  = (global_last - global_first) / Index(v_nthr); // size of initial sub-range (integer division)
+    const Index remain = (global_last - global_first) % Index(v_nthr); // remains of integer division
+    first              = chunk * Index(v_id) + global_first + MIN(Index(v_id), remain); // first iteration of sub-range
+    last = first + (chunk * v_size) + Index((Index(v_id) < remain) ? MIN(Index(remain - Index(v_id)), v_size) : 0);
+  }
+};
+
+/*
+ * Class: learned_distribution
+ * ---------------------------
+ *   Splits the loop in the proportions each thread executed on the previous runs of the same loop site, so a loop run
+ *   over and over starts close to balanced and steals only absorb the drift. The first run of a site is even. Each pool
+ *   (task_arena) learns a site on its own, so the same loop may run on several pools at once.
+ *
+ *   A site is any key unique to the loop: an explicit id, or ADAPT_LOOP_SITE for the address of the call site.
+ *
+ *     adapt::parallel_for(0, n, body, adapt::policy<adapt::default_victim, adapt::learned_distribution>(
+ *                                         adapt::default_victim(), adapt::learned_distribution(ADAPT_LOOP_SITE)));
+ */
+struct learned_distribution : __internal__::stateless_distribution {
+  explicit learned_distribution(const uintptr_t site) : _site(site), _history(nullptr), _executed(0) {}
+  explicit learned_distribution(const void *site) : learned_distribution(reinterpret_cast<uintptr_t>(site)) {}
+
+  template <class Index>
+  void start(const size_t nthr, const Index, const Index) const {
+    __internal__::get_loop_history(this->_site)->update(nthr);
+  }
+
+  template <class Index>
+  void range(const size_t id, const size_t, const Index global_first, const Index global_last, Index &first,
+             Index &last) const {
+    this->_history    = __internal__::get_loop_history(this->_site); // of the pool building this worker
+    const double size = double(global_last - global_first);
+    first             = global_first + Index(this->_history->bound[id] * size);
+    last              = global_first + Index(this->_history->bound[id + 1] * size);
+    if (id + 1 == this->_history->num_threads) last = global_last; // rounding never drops iterations
+  }
+
+  template <class Index>
+  void executed(const size_t, const Index first, const Index last) {
+    this->_executed += uint64_t(last - first);
+  }
+
+  void finish(const size_t id) { this->_history->executed[id] = this->_executed; } // once per worker: no false sharing
+
+private:
+  uintptr_t _site;
+  mutable __internal__::LoopHistory *_history; // set when the worker holding this copy is built
+  uint64_t _executed;                          // iterations executed by the worker holding this copy
+};
+
+/*
+ * Class: affinity_distribution
+ * ---------------------------
+ *   Each thread starts with the pieces of the loop it executed on the last run, stolen ones included, so iterative
+ *   loops keep their data in the same caches. It works through its pieces one at a time, and thieves steal from the
+ *   current one to rebalance as usual. The pieces are kept on an affinity_partitioner owned by the caller; its first
+ *   run is even.
+ *
+ *     adapt::affinity_partitioner ap;
+ *     for (int step = 0; step < steps; step++)
+ *       adapt::parallel_for(0, n, body, adapt::policy<adapt::default_victim, adapt::affinity_distribution>(
+ *                                           adapt::default_victim(), adapt::affinity_distribution(ap)));
+ */
+struct affinity_distribution {
+  explicit affinity_distribution(affinity_partitioner &partitioner) : _partitioner(&partitioner), _next_piece(1) {}
+
+  template <class Index>
+  void start(const size_t nthr, const Index global_first, const Index global_last) const {
+    this->_partitioner->start(nthr, int64_t(global_first), int64_t(global_last));
+  }
+
+  template <class Index>
+  void range(const size_t id, const size_t nthr, const Index global_first, const Index global_last, Index &first,
+             Index &last) const {
+    if (!this->_partitioner->replaying()) {
+      even_distribution().range(id, nthr, global_first, global_last, first, last);
+      return;
+    }
+    int64_t f = 0, l = 0; // a thread that executed nothing starts empty
+    this->_partitioner->piece(id, 0, f, l);
+    first = Index(f);
+    last  = Index(l);
+  }
+
+  template <class Index>
+  void executed(const size_t id, const Index first, const Index last) {
+    this->_partitioner->executed(id, int64_t(first), int64_t(last));
+  }
+
+  template <class Index>
+  bool next(const size_t id, Index &first, Index &last) {
+    int64_t f, l;
+    if (!this->_partitioner->piece(id, this->_next_piece, f, l)) return false;
+    this->_next_piece++;
+    first = Index(f);
+    last  = Index(l);
+    return true;
+  }
+
+  void finish(const size_t) {}
+
+private:
+  affinity_partitioner *_partitioner;
+  size_t _next_piece; // next piece replayed by the worker holding this copy
+};
+
+} // namespace adapt
+
+/*
+ * Macro: ADAPT_LOOP_SITE
+ * ---------------------------
+ *   Key unique to the place it is written in, for learned_distribution.
+ */
+#define ADAPT_LOOP_SITE                                                                                                \
+  ([]() -> const void * {                                                                                              \
+    static const char site = 0;                                                                                        \
+    return &site;                                                                                                      \
+  }())
+
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+#ifndef _ENUMERABLE_THREAD_SPECIFIC_HPP_
+#define _ENUMERABLE_THREAD_SPECIFIC_HPP_
+
+#include "_reduction.hpp"
+#include "adaptive.hpp"
+
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace adapt {
+
+/*
+ * Class: enumerable_thread_specific
+ * ---------------------------
+ *   One value of T per worker, created on the first call to local() by that worker and kept across chunks and loops,
+ *   so loop bodies reuse scratch memory without allocating or locking. Each value sits on a slot of its own cache
+ *   lines. New values are copies of an exemplar (T() by default).
+ *
+ *   Slots are indexed by this_worker_id(): a container is meant for the loops of one pool at a time. Outside loops,
+ *   local() is the slot of worker 0, the thread launching the loops.
+ *
+ *     adapt::enumerable_thread_specific<std::vector<double>> scratch;
+ *     adapt::parallel_for(0, n, [&](const int b, const int e) {
+ *       std::vector<double> &buffer = scratch.local();
+ *       ...
+ *     });
+ */
+template <class T>
+class enumerable_thread_specific {
+  struct Slot {
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    bool created;
+    char _pad[ADPT_CACHE_LINE]; // workers write on their own slots
+
+    Slot() : created(false) {}
+    T &value() { return *reinterpret_cast<T *>(&this->storage); }
+  };
+
+  const T _exemplar;
+  std::vector<Slot> _slots;
+
+public:
+  enumerable_thread_specific() : _exemplar(), _slots(ADPT_MAX_THREADS) {}
+  explicit enumerable_thread_specific(const T &exemplar) : _exemplar(exemplar), _slots(ADPT_MAX_THREADS) {}
+  enumerable_thread_specific(const enumerable_thread_specific &) = delete;
+  enumerable_thread_specific &operator=(const enumerable_thread_specific &) = delete;
+  ~enumerable_thread_specific() { this->clear(); }
+
+  /*
+   * Method: local
+   * ---------------------------
+   *   returns : the value of the current worker, created if it has none
+   */
+  T &local() {
+    bool exists;
+    return this->local(exists);
+  }
+
+  T &local(bool &exists) {
+    const int id = this_worker_id();
+    Slot &slot   = this->_slots[(id >= 0) ? size_t(id) : 0];
+    exists       = slot.created;
+    if (!exists) {
+      new (&slot.storage) T(this->_exemplar);
+      slot.created = true;
+    }
+    return slot.value();
+  }
+
+  // Number of values created
+  size_t size() const {
+    size_t count = 0;
+    for (const Slot &slot : this->_slots) count += slot.created ? 1 : 0;
+    return count;
+  }
+
+  bool empty() const { return this->size() == 0; }
+
+  // Destroys every value
+  void clear() {
+    for (Slot &slot : this->_slots) {
+      if (slot.created) slot.value().~T();
+      slot.created = false;
+    }
+  }
+
+  /*
+   * Method: combine_each
+   * ---------------------------
+   *   Calls function on every value, in worker order, on the current thread.
+   */
+  template <class Function>
+  void combine_each(const Function &function) {
+    for (Slot &slot : this->_slots)
+      if (slot.created) function(slot.value());
+  }
+
+  /*
+   * Method: combine
+   * ---------------------------
+   *   Combines every value with reduction, T = reduction(T, T) or the in-place reduction(T&, T&&), pairwise in
+   *   log2(size()) parallel loops. The values are moved out: the container is left empty.
+   *
+   *   returns : the combination, or a copy of the exemplar if no value was created
+   */
+  template <class Reduction>
+  T combine(const Reduction &reduction) {
+    std::vector<T *> values;
+    for (Slot &slot : this->_slots)
+      if (slot.created) values.push_back(&slot.value());
+    if (values.empty()) return this->_exemplar;
+
+    for (size_t step = 1; step < values.size(); step <<= 1) { // values[i] takes values[i + step]
+      const size_t pairs = (values.size() + 2 * step - 1) / (2 * step);
+      parallel_for(size_t(0), pairs, [&values, &reduction, step](const size_t b, const size_t e) {
+        for (size_t p = b; p < e; p++) {
+          const size_t i = p * 2 * step;
+          if (i + step < values.size()) __internal__::combine(reduction, *values[i], std::move(*values[i + step]));
+        }
+      });
+    }
+    T result(std::move(*values[0]));
+    this->clear();
+    return result;
+  }
+};
+
+} // namespace adapt
+
+#endif
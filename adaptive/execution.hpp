@@ -0,0 +1,500 @@
+#pragma once
+
+#ifndef _EXECUTION_HPP_
+#define _EXECUTION_HPP_
+
+#include "_futex.hpp"
+#include "algorithm.hpp"
+
+#if __cplusplus >= 201703L
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define ADPT_HAS_COROUTINES 1
+#else
+#define ADPT_HAS_COROUTINES 0
+#endif
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+// Calls function on the current thread with pool handler selected for the loops it launches; nested if the thread runs
+// a loop on it
+template <class Function>
+void on_pool(ThreadHandler &handler, const Function &function) {
+  if (current_handler == &handler) {
+    function();
+    return;
+  }
+  ArenaScope scope(handler);
+  function();
+}
+
+template <class Function, class Values>
+struct then_values;
+
+template <class Function, class... Values>
+struct then_values<Function, std::tuple<Values...>> {
+  typedef std::invoke_result_t<Function &, Values...> result_type;
+  typedef std::conditional_t<std::is_void<result_type>::value, std::tuple<>, std::tuple<result_type>> type;
+};
+
+// Result of co_await on a sender with values Values: void, the value, or the tuple of them
+template <class Values>
+struct single_value {
+  typedef Values type;
+};
+
+template <>
+struct single_value<std::tuple<>> {
+  typedef void type;
+};
+
+template <class Value>
+struct single_value<std::tuple<Value>> {
+  typedef Value type;
+};
+
+// Calls function(i, values...) on every index of the chunk [first, last) given by bulk_chunked
+template <class Function>
+struct each_index {
+  Function function;
+
+  template <class Shape, class... Values>
+  void operator()(const Shape first, const Shape last, Values &... values) const {
+    for (Shape i = first; i < last; i++) this->function(i, values...);
+  }
+};
+
+template <class Values>
+struct SyncWaitState {
+  std::optional<Values> values;
+  std::exception_ptr error;
+  std::atomic<uint32_t> done{0};
+
+  void complete() {
+    this->done.store(1, std::memory_order_release);
+    futex_wake_all(this->done);
+  }
+};
+
+template <class Values>
+struct SyncWaitReceiver {
+  SyncWaitState<Values> *state;
+
+  template <class... Completion>
+  void set_value(Completion &&... values) {
+    this->state->values.emplace(std::forward<Completion>(values)...);
+    this->state->complete();
+  }
+
+  void set_error(std::exception_ptr error) {
+    this->state->error = std::move(error);
+    this->state->complete();
+  }
+};
+
+} // namespace __internal__
+
+namespace execution {
+
+/*
+ * Senders and receivers
+ * ---------------------------
+ *   A standalone subset of the std::execution (P2300) model, for C++17 and later, with the adaptive pool as scheduler.
+ *   A sender describes work that completes with values; connecting it to a receiver gives an operation state, whose
+ *   start() runs the work and completes the receiver with receiver.set_value(values...) or
+ *   receiver.set_error(std::exception_ptr). Senders expose their values as value_types (a std::tuple), connect() is a
+ *   member, and completion functions are members of the receiver.
+ *
+ *   schedule and bulk move the work onto the pool: started from another thread, they launch a detached loop on the
+ *   pool threads and return at once. The pool thread executing the last share of the loop completes the receiver,
+ *   with the pool still running the loop, so the rest of the chain runs there and its bulk operations are nested
+ *   loops, shared with the threads out of work; the pool is released once the chain returns. Started on a thread of
+ *   the pool (from a loop body, a task, or a chain already there), or on a pool of one thread, schedule completes at
+ *   once and bulk runs as a nested loop, so chains on pool threads never block one. bulk splits its index space
+ *   through adaptive extraction and stealing (auto_grain, as the parallel algorithms); bulk_chunked passes each
+ *   extracted chunk [first, last) to its function.
+ *
+ *     adapt::execution::scheduler pool;
+ *     auto work = adapt::execution::schedule(pool) | adapt::execution::then([&]() { return load(); }) |
+ *                 adapt::execution::bulk(n, [](const size_t i, batch &b) { b.process(i); });
+ *     std::optional<std::tuple<batch>> result = adapt::execution::sync_wait(std::move(work));
+ *
+ *   With coroutine support, senders are awaitable: batch b = co_await std::move(work);
+ *   Exceptions thrown by then functions complete with set_error; bulk functions must not throw.
+ */
+
+/*
+ * Class: scheduler
+ * ---------------------------
+ *   Handle to the pool active when it is built: the global one, or the one of the task_arena whose execute() builds
+ *   it.
+ */
+class scheduler {
+  __internal__::ThreadHandler *_handler;
+
+public:
+  scheduler() : _handler(&__internal__::active_handler()) {}
+
+  size_t num_threads() const { return this->_handler->num_threads; }
+  __internal__::ThreadHandler &handler() const { return *this->_handler; }
+
+  bool operator==(const scheduler &other) const { return this->_handler == other._handler; }
+  bool operator!=(const scheduler &other) const { return this->_handler != other._handler; }
+};
+
+/*
+ * Function: adapt::execution::just
+ * ---------------------------
+ *   Sender completing with copies of values on the thread that starts it.
+ */
+template <class... Values>
+class just_sender {
+  std::tuple<Values...> _values;
+
+public:
+  typedef std::tuple<Values...> value_types;
+
+  template <class Receiver>
+  struct operation {
+    std::tuple<Values...> values;
+    Receiver receiver;
+
+    void start() {
+      std::apply([this](Values &... values) { this->receiver.set_value(std::move(values)...); }, this->values);
+    }
+  };
+
+  explicit just_sender(Values... values) : _values(std::move(values)...) {}
+
+  template <class Receiver>
+  operation<Receiver> connect(Receiver receiver) const {
+    return operation<Receiver>{this->_values, std::move(receiver)};
+  }
+};
+
+template <class... Values>
+just_sender<std::decay_t<Values>...> just(Values &&... values) {
+  return just_sender<std::decay_t<Values>...>(std::forward<Values>(values)...);
+}
+
+/*
+ * Function: adapt::execution::schedule
+ * ---------------------------
+ *   Sender completing with no value on a thread of pool, which then runs the loops of what follows.
+ */
+class schedule_sender {
+  scheduler _scheduler;
+
+public:
+  typedef std::tuple<> value_types;
+
+  template <class Receiver>
+  struct operation {
+    scheduler pool;
+    Receiver receiver;
+
+    void start() {
+      using namespace __internal__;
+      ThreadHandler &handler = this->pool.handler();
+      if (!can_detach(handler)) { // already on the pool
+        on_pool(handler, [this]() { this->receiver.set_value(); });
+        return;
+      }
+      launch_detached_for(handler, 0, 1, [](const int, const int) {}, default_policy(),
+                          [this]() { this->receiver.set_value(); });
+    }
+  };
+
+  explicit schedule_sender(const scheduler &pool) : _scheduler(pool) {}
+
+  template <class Receiver>
+  operation<Receiver> connect(Receiver receiver) const {
+    return operation<Receiver>{this->_scheduler, std::move(receiver)};
+  }
+};
+
+inline schedule_sender schedule(const scheduler &pool) { return schedule_sender(pool); }
+
+/*
+ * Function: adapt::execution::then
+ * ---------------------------
+ *   Sender completing with function(values...) of sender, or with no value if function returns void.
+ */
+template <class Sender, class Function>
+class then_sender {
+  Sender _sender;
+  Function _function;
+
+public:
+  typedef typename __internal__::then_values<Function, typename Sender::value_types>::type value_types;
+
+  template <class Receiver>
+  struct receiver {
+    Receiver next;
+    Function function;
+
+    template <class... Values>
+    void set_value(Values &&... values) {
+      typedef std::invoke_result_t<Function &, Values...> result_t;
+      if constexpr (std::is_void<result_t>::value) {
+        try {
+          std::invoke(this->function, std::forward<Values>(values)...);
+        } catch (...) {
+          this->next.set_error(std::current_exception());
+          return;
+        }
+        this->next.set_value();
+      } else {
+        std::optional<result_t> result;
+        try {
+          result.emplace(std::invoke(this->function, std::forward<Values>(values)...));
+        } catch (...) {
+          this->next.set_error(std::current_exception());
+          return;
+        }
+        this->next.set_value(std::move(*result));
+      }
+    }
+
+    void set_error(std::exception_ptr error) { this->next.set_error(std::move(error)); }
+  };
+
+  then_sender(Sender sender, Function function) : _sender(std::move(sender)), _function(std::move(function)) {}
+
+  template <class Receiver>
+  auto connect(Receiver next) const {
+    return this->_sender.connect(receiver<Receiver>{std::move(next), this->_function});
+  }
+};
+
+/*
+ * Function: adapt::execution::bulk_chunked
+ * ---------------------------
+ *   Sender running function(first, last, values...) on the chunks of [0, shape) as an adaptive loop on the pool in
+ *   use, then completing with the values of sender on the thread executing the last chunk. Values are passed as
+ *   lvalues, shared by every chunk.
+ */
+template <class Sender, class Shape, class Function, class Policy>
+class bulk_sender {
+  Sender _sender;
+  Shape _shape;
+  Function _function;
+  Policy _policy;
+
+public:
+  typedef typename Sender::value_types value_types;
+
+  template <class Receiver>
+  struct receiver {
+    Receiver next;
+    Shape shape;
+    Function function;
+    Policy policy;
+    std::optional<value_types> values; // kept for the detached loop
+
+    template <class... Values>
+    void set_value(Values &&... values) {
+      using namespace __internal__;
+      ThreadHandler &handler = active_handler();
+      if (!can_detach(handler)) { // on the pool: nested loop
+        const Function &function = this->function;
+        parallel_for(
+          Shape(0), this->shape, [&](const Shape first, const Shape last) { function(first, last, values...); },
+          this->policy);
+        this->next.set_value(std::forward<Values>(values)...);
+        return;
+      }
+
+      this->values.emplace(std::forward<Values>(values)...);
+      auto chunk = [this](const Shape first, const Shape last) {
+        const Function &function = this->function;
+        std::apply([&](auto &... kept) { function(first, last, kept...); }, *this->values);
+      };
+      auto complete = [this]() {
+        std::apply([this](auto &... kept) { this->next.set_value(std::move(kept)...); }, *this->values);
+      };
+      launch_detached_for(handler, Shape(0), this->shape, chunk, this->policy, complete);
+    }
+
+    void set_error(std::exception_ptr error) { this->next.set_error(std::move(error)); }
+  };
+
+  bulk_sender(Sender sender, const Shape shape, Function function, const Policy &policy) :
+      _sender(std::move(sender)), _shape(shape), _function(std::move(function)), _policy(policy) {}
+
+  template <class Receiver>
+  auto connect(Receiver next) const {
+    return this->_sender.connect(receiver<Receiver>{std::move(next), this->_shape, this->_function, this->_policy, {}});
+  }
+};
+
+/*
+ * Struct: sender_closure
+ * ---------------------------
+ *   Adaptor waiting for its sender: sender | then(function) is then(sender, function).
+ */
+template <class Adaptor>
+struct sender_closure {
+  Adaptor adaptor;
+};
+
+template <class Sender, class Adaptor>
+auto operator|(Sender &&sender, const sender_closure<Adaptor> &closure) {
+  return closure.adaptor(std::forward<Sender>(sender));
+}
+
+template <class Sender, class Function>
+then_sender<std::decay_t<Sender>, std::decay_t<Function>> then(Sender &&sender, Function &&function) {
+  return then_sender<std::decay_t<Sender>, std::decay_t<Function>>(std::forward<Sender>(sender),
+                                                                     std::forward<Function>(function));
+}
+
+template <class Function>
+auto then(Function function) {
+  auto adaptor = [function](auto &&sender) { return then(std::forward<decltype(sender)>(sender), function); };
+  return sender_closure<decltype(adaptor)>{adaptor};
+}
+
+template <class Sender, class Shape, class Function, class Policy>
+bulk_sender<std::decay_t<Sender>, Shape, std::decay_t<Function>, Policy>
+bulk_chunked(Sender &&sender, const Shape shape, Function &&function, const Policy &policy) {
+  return bulk_sender<std::decay_t<Sender>, Shape, std::decay_t<Function>, Policy>(
+    std::forward<Sender>(sender), shape, std::forward<Function>(function), policy);
+}
+
+template <class Sender, class Shape, class Function>
+auto bulk_chunked(Sender &&sender, const Shape shape, Function &&function) {
+  return bulk_chunked(std::forward<Sender>(sender), shape, std::forward<Function>(function), algorithm_policy());
+}
+
+template <class Shape, class Function>
+auto bulk_chunked(const Shape shape, Function function) {
+  auto adaptor = [shape, function](auto &&sender) {
+    return bulk_chunked(std::forward<decltype(sender)>(sender), shape, function);
+  };
+  return sender_closure<decltype(adaptor)>{adaptor};
+}
+
+/*
+ * Function: adapt::execution::bulk
+ * ---------------------------
+ *   Sender calling function(i, values...) for every i of [0, shape), then completing with the values of sender.
+ */
+template <class Sender, class Shape, class Function, class Policy>
+auto bulk(Sender &&sender, const Shape shape, Function &&function, const Policy &policy) {
+  typedef __internal__::each_index<std::decay_t<Function>> each_t;
+  return bulk_chunked(std::forward<Sender>(sender), shape, each_t{std::forward<Function>(function)}, policy);
+}
+
+template <class Sender, class Shape, class Function>
+auto bulk(Sender &&sender, const Shape shape, Function &&function) {
+  return bulk(std::forward<Sender>(sender), shape, std::forward<Function>(function), algorithm_policy());
+}
+
+template <class Shape, class Function>
+auto bulk(const Shape shape, Function function) {
+  auto adaptor = [shape, function](auto &&sender) {
+    return bulk(std::forward<decltype(sender)>(sender), shape, function);
+  };
+  return sender_closure<decltype(adaptor)>{adaptor};
+}
+
+/*
+ * Function: adapt::execution::sync_wait
+ * ---------------------------
+ *   Starts sender and sleeps until its completion, on the current thread or on the pool. Errors are rethrown.
+ *
+ *   returns : the values of sender
+ */
+template <class Sender>
+std::optional<typename std::decay_t<Sender>::value_types> sync_wait(Sender &&sender) {
+  typedef typename std::decay_t<Sender>::value_types values_t;
+  __internal__::SyncWaitState<values_t> state;
+  auto operation = sender.connect(__internal__::SyncWaitReceiver<values_t>{&state});
+  operation.start();
+  while (state.done.load(std::memory_order_acquire) == 0) __internal__::futex_wait(state.done, 0);
+  if (state.error) std::rethrow_exception(state.error);
+  return std::move(state.values);
+}
+
+#if ADPT_HAS_COROUTINES
+/*
+ * Class: sender_awaiter
+ * ---------------------------
+ *   co_await on a sender: starts it and resumes the coroutine with its value (void, the value, or a tuple of them), or
+ *   rethrows its error. The coroutine is resumed on the pool thread completing the sender, and does not suspend when
+ *   the sender completes inline, started on a thread of its pool.
+ */
+template <class Sender>
+class sender_awaiter {
+  typedef typename Sender::value_types values_t;
+  enum { STARTED, SUSPENDED, COMPLETED };
+
+  struct receiver {
+    sender_awaiter *awaiter;
+
+    template <class... Values>
+    void set_value(Values &&... values) {
+      this->awaiter->_values.emplace(std::forward<Values>(values)...);
+      this->awaiter->complete();
+    }
+
+    void set_error(std::exception_ptr error) {
+      this->awaiter->_error = std::move(error);
+      this->awaiter->complete();
+    }
+  };
+
+  std::optional<values_t> _values;
+  std::exception_ptr _error;
+  std::atomic<int> _state{STARTED};
+  std::coroutine_handle<> _handle;
+  decltype(std::declval<const Sender &>().connect(std::declval<receiver>())) _operation;
+
+  void complete() {
+    if (this->_state.exchange(COMPLETED) == SUSPENDED) this->_handle.resume();
+  }
+
+public:
+  explicit sender_awaiter(const Sender &sender) : _operation(sender.connect(receiver{this})) {}
+
+  bool await_ready() const { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    this->_handle = handle;
+    this->_operation.start();
+    return this->_state.exchange(SUSPENDED) != COMPLETED; // else resumes at once
+  }
+
+  typename __internal__::single_value<values_t>::type await_resume() {
+    if (this->_error) std::rethrow_exception(this->_error);
+    if constexpr (std::tuple_size<values_t>::value == 1)
+      return std::move(std::get<0>(*this->_values));
+    else if constexpr (std::tuple_size<values_t>::value > 1)
+      return std::move(*this->_values);
+  }
+};
+
+template <class Sender, class = typename std::decay_t<Sender>::value_types>
+sender_awaiter<std::decay_t<Sender>> operator co_await(Sender &&sender) {
+  return sender_awaiter<std::decay_t<Sender>>(sender);
+}
+#endif
+
+} // namespace execution
+} // namespace adapt
+
+#endif // __cplusplus >= 201703L
+
+#endif
@@ -0,0 +1,165 @@
+#pragma once
+
+#ifndef _GRAIN_HPP_
+#define _GRAIN_HPP_
+
+#include "_defines.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace adapt {
+
+/*
+ * Grain policies
+ * ---------------------------
+ *   A grain policy sizes the chunks a worker extracts from its own sub-range. Each worker owns a copy of the grain
+ *   from the loop policy, and calls:
+ *
+ *       chunk(range_size, is_LITTLE) : grain for a new sub-range of range_size iterations
+ *     extract(worker)                : size of the next extraction, from worker.seq_chunk and its remaining work
+ *       start()                      : before the loop body runs an extracted chunk
+ *      finish(seq_chunk, iterations) : after the loop body ran a chunk of iterations; may update seq_chunk
+ */
+
+/*
+ * Class: fixed_grain
+ * ---------------------------
+ *   Constant grain, from ADAPT_GRAIN (1 by default). Default policy.
+ */
+struct fixed_grain {
+  template <class Index>
+  Index chunk(const Index, const bool) const {
+    return Index(__internal__::get_grain());
+  }
+
+  template <class Worker>
+  auto extract(const Worker &worker) const -> decltype(worker.seq_chunk) {
+    return worker.seq_chunk;
+  }
+
+  inline void start() {}
+
+  template <class Index>
+  void finish(Index &, const Index) {}
+};
+
+/*
+ * Class: fraction_grain
+ * ---------------------------
+ *   Grain is a fraction of the sub-range: range_size / fraction. Without an explicit fraction, uses ADAPT_GRAIN (256
+ *   by default).
+ */
+struct fraction_grain : fixed_grain {
+  size_t fraction;
+
+  fraction_grain(const size_t _fraction = 0) : fraction(_fraction) {}
+
+  template <class Index>
+  Index chunk(const Index range_size, const bool) const {
+    const Index _fraction = Index(this->fraction ? this->fraction : __internal__::get_grain_fraction());
+    return MAX(range_size / _fraction, Index(1));
+  }
+};
+
+/*
+ * Class: log_grain
+ * ---------------------------
+ *   Grain is log2 of the sub-range size.
+ */
+struct log_grain : fixed_grain {
+  template <class Index>
+  Index chunk(const Index range_size, const bool) const {
+    return MAX(Index(std::log2(range_size)), Index(1));
+  }
+};
+
+/*
+ * Class: little_grain
+ * ---------------------------
+ *   LITTLE cores use a grain ALPHA times smaller than the one of Grain.
+ */
+template <class Grain>
+struct little_grain : Grain {
+  little_grain(const Grain &grain = Grain()) : Grain(grain) {}
+
+  template <class Index>
+  Index chunk(const Index range_size, const bool is_LITTLE) const {
+    const Index grain = Grain::chunk(range_size, is_LITTLE);
+    return is_LITTLE ? MAX(grain / Index(__internal__::get_alpha()), Index(1)) : grain;
+  }
+};
+
+/*
+ * Class: threshold_grain
+ * ---------------------------
+ *   Extracts single iterations once fewer than 4 grains of work remain on the sub-range.
+ */
+template <class Grain>
+struct threshold_grain : Grain {
+  threshold_grain(const Grain &grain = Grain()) : Grain(grain) {}
+
+  template <class Worker>
+  auto extract(const Worker &worker) const -> decltype(worker.seq_chunk) {
+    typedef decltype(worker.seq_chunk) Index;
+    const Index grain = Grain::extract(worker);
+    return (Index(worker.last - worker.copy_first) > (grain << 2)) ? grain : Index(1);
+  }
+};
+
+/*
+ * Class: auto_grain
+ * ---------------------------
+ *   Tunes the grain of each worker online. Every chunk is timed, and the grain moves toward the number of iterations
+ *   that takes target_ns at the measured cost per iteration. It changes by at most a factor of 2 per chunk, and the
+ *   learned grain is kept across steals.
+ *
+ *   target_ns : target duration of a chunk, in nanoseconds (10 us by default)
+ *     initial : grain of the first chunk
+ */
+struct auto_grain : fixed_grain {
+  typedef std::chrono::steady_clock clock;
+
+  uint64_t target_ns;
+  size_t learned;
+  clock::time_point started;
+
+  auto_grain(const uint64_t _target_ns = 10000, const size_t initial = 1) :
+      target_ns(_target_ns), learned(MAX(initial, size_t(1))) {}
+
+  template <class Index>
+  Index chunk(const Index, const bool) const {
+    return Index(this->learned);
+  }
+
+  inline void start() { this->started = clock::now(); }
+
+  template <class Index>
+  void finish(Index &seq_chunk, const Index iterations) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - this->started);
+    this->observe(seq_chunk, iterations, uint64_t(elapsed.count()));
+  }
+
+  /*
+   * Method: observe
+   * --------------------------
+   *   Updates seq_chunk after a chunk of iterations took elapsed_ns.
+   */
+  template <class Index>
+  void observe(Index &seq_chunk, const Index iterations, const uint64_t elapsed_ns) {
+    if (!(iterations > 0)) return;
+    const double per_iteration = double(MAX(elapsed_ns, uint64_t(1))) / double(iterations);
+    const double ideal         = double(this->target_ns) / per_iteration;
+    const double current       = double(seq_chunk);
+    const double bounded       = MIN(MAX(ideal, current / 2.0), current * 2.0);
+    const double limit         = double(std::numeric_limits<Index>::max() / 2);
+    seq_chunk                  = Index(MAX(MIN(bounded, limit), 1.0));
+    this->learned              = size_t(seq_chunk);
+  }
+};
+
+} // namespace adapt
+
+#endif
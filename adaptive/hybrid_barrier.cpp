@@ -0,0 +1,50 @@
+#include "hybrid_barrier.hpp"
+
+#include "_futex.hpp"
+
+namespace adapt {
+
+using namespace __internal__;
+
+const uint64_t HybridBarrier::DEFAULT_SPIN_NS;
+
+HybridBarrier::HybridBarrier() : HybridBarrier(1) {}
+
+HybridBarrier::HybridBarrier(int _participants, uint64_t _spin_ns) :
+    _counter(0), _generation(0), _sleepers(0), _participants(_participants), _spin_ns(_spin_ns) {}
+
+void HybridBarrier::set_participants(size_t _participants) {
+  this->_counter      = 0;
+  this->_participants = _participants;
+}
+
+void HybridBarrier::set_spin(uint64_t _spin_ns) { this->_spin_ns = _spin_ns; }
+
+uint64_t HybridBarrier::get_spin() const { return this->_spin_ns; }
+
+void HybridBarrier::reset() { _counter = 0; }
+
+void HybridBarrier::wait() {
+  size_t partial = this->_counter++;
+  size_t end     = partial - (partial % this->_participants) + this->_participants;
+
+  if (partial + 1 == end) { // last participant releases the others
+    this->_generation++;
+    if (this->_sleepers > 0) futex_wake_all(this->_generation);
+    return;
+  }
+
+  if (!spin_until([this, end]() { return this->_counter >= end; }, this->_spin_ns)) {
+    this->_sleepers++;
+    while (true) {
+      const uint32_t generation = this->_generation; // read before the check: a later release changes it
+      if (this->_counter >= end) break;
+      futex_wait(this->_generation, generation);
+    }
+    this->_sleepers--;
+  }
+}
+
+bool HybridBarrier::is_free() { return (this->_counter % this->_participants) == 0; }
+
+} // namespace adapt
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef _HYBRID_BARRIER_
+#define _HYBRID_BARRIER_
+
+#include <atomic>
+#include <cstdint>
+#include <unistd.h>
+
+namespace adapt {
+
+/*
+ * Class: HybridBarrier
+ * ---------------------------
+ *   Same interface as AtomicBarrier, but waiting threads only spin for a bounded time and then sleep on a futex
+ *   until the last participant arrives. Short waits keep the latency of a busy-wait, long ones leave the cores idle.
+ */
+class HybridBarrier {
+private:
+  std::atomic<size_t> _counter;
+  std::atomic<uint32_t> _generation; // futex word, bumped by the last participant of each round
+  std::atomic<size_t> _sleepers;     // threads that may be sleeping on the futex
+  size_t _participants;
+  std::atomic<uint64_t> _spin_ns;
+
+public:
+  static const uint64_t DEFAULT_SPIN_NS = 100000;
+
+  HybridBarrier();
+  HybridBarrier(int _participants, uint64_t _spin_ns = DEFAULT_SPIN_NS);
+  void set_participants(size_t _participants);
+
+  /*
+   * Method: set_spin
+   * ---------------------------
+   *   Time a waiting thread spins before sleeping. 0 sleeps right away, UINT64_MAX never sleeps.
+   */
+  void set_spin(uint64_t _spin_ns);
+  uint64_t get_spin() const;
+  void reset();
+  void wait();
+  bool is_free();
+};
+
+} // namespace adapt
+
+#endif
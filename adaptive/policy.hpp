@@ -0,0 +1,126 @@
+#pragma once
+
+#ifndef _POLICY_HPP_
+#define _POLICY_HPP_
+
+#include "distribution.hpp"
+#include "grain.hpp"
+#include "steal.hpp"
+#include "victim_selection.hpp"
+
+namespace adapt {
+
+/*
+ * Default strategies
+ * ---------------------------
+ *   The former compile-time switches still select the strategies of the default policy, so existing builds keep their
+ *   behavior. Any loop can override them with its own adapt::policy.
+ */
+typedef hierarchical_victim default_victim;
+
+#ifdef DISTRIB_BY_DEMAND // thread 0 starts with entire range
+typedef demand_distribution default_distribution;
+#elif DISTRIB_BY_ALPHA // big cores have initial range ALPHA times bigger
+typedef alpha_distribution default_distribution;
+#else // divides initial range equally
+typedef even_distribution default_distribution;
+#endif
+
+namespace __internal__ // anonymous namespace
+{
+
+#ifdef GRAIN_FRACTION
+typedef fraction_grain grain_base;
+#elif GRAIN_LOG
+typedef log_grain grain_base;
+#else
+typedef fixed_grain grain_base;
+#endif
+#ifdef GRAIN_SMALLER_LITTLE
+typedef little_grain<grain_base> grain_little;
+#else
+typedef grain_base grain_little;
+#endif
+#ifdef EXTRACT_THRESHOLD
+typedef threshold_grain<grain_little> grain_default;
+#else
+typedef grain_little grain_default;
+#endif
+
+#ifdef STEAL_HALF
+typedef steal_half steal_base;
+#else // STEAL_HALF_REMAINING
+typedef steal_half_remaining steal_base;
+#endif
+#ifdef STEAL_SMALLER_LITTLE
+typedef little_steal<steal_base> steal_little;
+#else
+typedef steal_base steal_little;
+#endif
+#ifdef STEAL_THRESHOLD_LITTLE
+typedef little_threshold_steal<steal_little> steal_threshold;
+#else
+typedef steal_little steal_threshold;
+#endif
+#ifdef STEAL_ONLY_FROM_LITTLE
+typedef from_little_steal<steal_threshold> steal_from_little;
+#else
+typedef steal_threshold steal_from_little;
+#endif
+#ifdef REDUCE_GRAIN_ON_STEAL
+typedef reduce_grain_steal<steal_from_little> steal_default;
+#else
+typedef steal_from_little steal_default;
+#endif
+
+} // namespace __internal__
+
+typedef __internal__::grain_default default_grain;
+typedef __internal__::steal_default default_steal;
+
+/*
+ * Struct: adapt::policy
+ * ---------------------------
+ *   Scheduling policy of a loop, optionally given as the last argument of parallel_for/parallel_reduce. Each template
+ *   parameter selects a strategy at compile time, so unused strategies cost nothing; the members carry their runtime
+ *   settings.
+ *
+ *         Victim : victim selection on steals (hierarchical_victim, xorshift_victim, round_robin_victim,
+ *                  nearest_victim, richest_victim)
+ *   Distribution : initial sub-ranges (even_distribution, demand_distribution, alpha_distribution,
+ *                  learned_distribution, affinity_distribution)
+ *          Grain : size of sequential extractions (fixed_grain, fraction_grain, log_grain, auto_grain,
+ *                  little_grain<>, threshold_grain<>)
+ *          Steal : size of steals (steal_half_remaining, steal_half, little_steal<>, little_threshold_steal<>,
+ *                  from_little_steal<>, reduce_grain_steal<>)
+ */
+template <class Victim       = default_victim,
+          class Distribution = default_distribution,
+          class Grain        = default_grain,
+          class Steal        = default_steal>
+struct policy {
+  typedef Victim victim_type;
+  typedef Distribution distribution_type;
+  typedef Grain grain_type;
+  typedef Steal steal_type;
+
+  Victim victim;
+  Distribution distribution;
+  Grain grain;
+  Steal steal;
+
+  policy(const Victim &_victim             = Victim(),
+         const Distribution &_distribution = Distribution(),
+         const Grain &_grain               = Grain(),
+         const Steal &_steal               = Steal()) :
+      victim(_victim), distribution(_distribution), grain(_grain), steal(_steal) {}
+};
+
+typedef policy<> default_policy;
+
+// Default policy of parallel_scan: thread 0 scans the whole loop for good from the start, the others pre-scan steals
+typedef policy<default_victim, demand_distribution> scan_policy;
+
+} // namespace adapt
+
+#endif
@@ -0,0 +1,147 @@
+#pragma once
+
+#ifndef _STEAL_HPP_
+#define _STEAL_HPP_
+
+#include "_defines.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace adapt {
+
+/*
+ * Steal policies
+ * ---------------------------
+ *   A steal policy decides how much a thief takes from the end of a victim's sub-range:
+ *
+ *     allowed(thief, victim)         : whether the thief may inspect this victim at all
+ *        size(thief, victim, v_last) : iterations to steal, called with the victim locked and v_last its last
+ *                                      iteration. Returning 0 cancels the steal
+ *      stolen(victim)                : called with the victim still locked after a successful steal
+ *     refresh(owner)                 : called by the owner before each sequential chunk, to apply what thieves asked
+ *
+ *   Packed sub-ranges (indices up to 32 bits) are stolen without the lock: size() works on a snapshot, validated by
+ *   the thief's CAS, and stolen() is called right after the CAS succeeds. Several thieves may then run size() and
+ *   stolen() on the same victim at once, concurrently with its owner, so they only write the atomic fields of the
+ *   victim (half_range, grain_cuts). State owned by the victim, like its grain, is changed by refresh().
+ */
+
+/*
+ * Class: steal_half_remaining
+ * ---------------------------
+ *   Steals half of the remaining work of the victim. Default policy.
+ */
+struct steal_half_remaining {
+  template <class Worker>
+  bool allowed(const Worker &, const Worker &) const {
+    return true;
+  }
+
+  template <class Worker, class Index>
+  Index size(const Worker &, const Worker &victim, const Index vic_last) const {
+    const Index first  = victim.first;
+    const Index remain = (vic_last > first) ? Index(vic_last - first) : Index(0);
+    return (remain > 0) ? MAX(Index(remain >> 1), Index(1)) : Index(0);
+  }
+
+  template <class Worker>
+  void stolen(Worker &) const {}
+
+  template <class Worker>
+  void refresh(Worker &) const {}
+};
+
+/*
+ * Class: steal_half
+ * ---------------------------
+ *   Steals half of the victim's original sub-range, halving it on each steal until it fits in the remaining work.
+ */
+struct steal_half : steal_half_remaining {
+  template <class Worker, class Index>
+  Index size(const Worker &, Worker &victim, const Index vic_last) const {
+    Index steal_size = victim.half_range.load(std::memory_order_relaxed);
+    while (true) {
+      // a concurrent thief took this size: retry with the value it left
+      if (!victim.half_range.compare_exchange_weak(steal_size, Index(steal_size >> 1), std::memory_order_relaxed))
+        continue;
+      if (!steal_size || !(victim.first > (vic_last - steal_size))) return steal_size;
+      steal_size >>= 1;
+    }
+  }
+};
+
+/*
+ * Class: little_steal
+ * ---------------------------
+ *   LITTLE thieves steal ALPHA times less than Steal.
+ */
+template <class Steal>
+struct little_steal : Steal {
+  little_steal(const Steal &steal = Steal()) : Steal(steal) {}
+
+  template <class Worker, class Index>
+  Index size(const Worker &thief, Worker &victim, const Index vic_last) const {
+    const Index steal_size = Steal::size(thief, victim, vic_last);
+    return thief.is_LITTLE ? Index(steal_size / Index(__internal__::get_alpha())) : steal_size;
+  }
+};
+
+/*
+ * Class: little_threshold_steal
+ * ---------------------------
+ *   LITTLE thieves cancel steals smaller than the victim's minimal steal size (sqrt of its sub-range).
+ */
+template <class Steal>
+struct little_threshold_steal : Steal {
+  little_threshold_steal(const Steal &steal = Steal()) : Steal(steal) {}
+
+  template <class Worker, class Index>
+  Index size(const Worker &thief, Worker &victim, const Index vic_last) const {
+    const Index steal_size = Steal::size(thief, victim, vic_last);
+    return (thief.is_LITTLE && (steal_size < victim.min_steal)) ? Index(0) : steal_size;
+  }
+};
+
+/*
+ * Class: from_little_steal
+ * ---------------------------
+ *   Thieves only steal from LITTLE cores.
+ */
+template <class Steal>
+struct from_little_steal : Steal {
+  from_little_steal(const Steal &steal = Steal()) : Steal(steal) {}
+
+  template <class Worker>
+  bool allowed(const Worker &thief, const Worker &victim) const {
+    return victim.is_LITTLE && Steal::allowed(thief, victim);
+  }
+};
+
+/*
+ * Class: reduce_grain_steal
+ * ---------------------------
+ *   Each steal halves the grain of the victim. Thieves count the cuts, the victim applies them to its own grain.
+ */
+template <class Steal>
+struct reduce_grain_steal : Steal {
+  reduce_grain_steal(const Steal &steal = Steal()) : Steal(steal) {}
+
+  template <class Worker>
+  void stolen(Worker &victim) const {
+    Steal::stolen(victim);
+    victim.grain_cuts.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  template <class Worker>
+  void refresh(Worker &owner) const {
+    Steal::refresh(owner);
+    if (owner.grain_cuts.load(std::memory_order_relaxed) == 0) return;
+    const uint32_t cuts = owner.grain_cuts.exchange(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < cuts && owner.seq_chunk > 1; i++) owner.seq_chunk >>= 1;
+  }
+};
+
+} // namespace adapt
+
+#endif
@@ -0,0 +1,35 @@
+#include "task_arena.hpp"
+
+#include <new>
+
+namespace adapt {
+namespace __internal__ {
+
+ArenaScope::ArenaScope(ThreadHandler &handler) :
+    previous_selected(selected_handler), previous_current(current_handler), previous_id(current_thread_id) {
+  selected_handler  = &handler;
+  current_handler   = nullptr;
+  current_thread_id = -1;
+}
+
+ArenaScope::~ArenaScope() {
+  selected_handler  = this->previous_selected;
+  current_handler   = this->previous_current;
+  current_thread_id = this->previous_id;
+}
+
+} // namespace __internal__
+
+task_arena::task_arena(size_t num_threads) {
+  this->_storage.reserve(1, sizeof(__internal__::ThreadHandler), alignof(__internal__::ThreadHandler));
+  this->_handler = new (this->_storage.slot(0)) __internal__::ThreadHandler(num_threads, std::vector<int>());
+}
+
+task_arena::task_arena(const std::vector<int> &cpus) {
+  this->_storage.reserve(1, sizeof(__internal__::ThreadHandler), alignof(__internal__::ThreadHandler));
+  this->_handler = new (this->_storage.slot(0)) __internal__::ThreadHandler(cpus.size(), cpus);
+}
+
+task_arena::~task_arena() { this->_handler->~ThreadHandler(); }
+
+} // namespace adapt
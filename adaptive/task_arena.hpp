@@ -0,0 +1,74 @@
+#pragma once
+
+#ifndef _TASK_ARENA_HPP_
+#define _TASK_ARENA_HPP_
+
+#include "_thread_handler.hpp"
+#include "_worker_arena.hpp"
+
+#include <vector>
+
+namespace adapt {
+namespace __internal__ // anonymous namespace
+{
+
+/*
+ * Struct: ArenaScope
+ * --------------------------
+ *   Selects a pool for the loops launched by the current thread while in scope. A thread running a loop launches
+ *   new loops on the selected pool instead of nesting them in the running one.
+ */
+struct ArenaScope {
+  ThreadHandler *previous_selected;
+  ThreadHandler *previous_current;
+  int previous_id;
+
+  ArenaScope(ThreadHandler &handler);
+  ~ArenaScope();
+};
+
+} // namespace __internal__
+
+/*
+ * Class: task_arena
+ * ---------------------------
+ *   Thread pool of its own, on a subset of the cores or with a share of the threads. Loops launched inside
+ *   execute() run on the arena's threads instead of the global ones, so threads of an application running loops on
+ *   different arenas do not wait for each other. Any thread may launch loops on an arena; loops launched on the same
+ *   arena by several threads run one after the other.
+ *
+ *     adapt::task_arena arena({0, 1, 2, 3}); // 4 threads pinned on cpus 0 to 3
+ *     arena.execute([&]() { adapt::parallel_for(0, n, body); });
+ */
+class task_arena {
+  __internal__::WorkerArena _storage; // aligned storage of the pool
+  __internal__::ThreadHandler *_handler;
+
+public:
+  // num_threads threads, not pinned (the launching thread counts as one)
+  explicit task_arena(size_t num_threads);
+  // one thread per cpu, pinned
+  explicit task_arena(const std::vector<int> &cpus);
+  task_arena(const task_arena &) = delete;
+  task_arena &operator=(const task_arena &) = delete;
+  ~task_arena();
+
+  size_t num_threads() const { return this->_handler->num_threads; }
+
+  /*
+   * Method: execute
+   * ---------------------------
+   *   Calls function on the current thread, with the loops it launches running on this arena.
+   *
+   *   returns : the value returned by function
+   */
+  template <class Function>
+  auto execute(const Function &function) const -> decltype(function()) {
+    __internal__::ArenaScope scope(*this->_handler);
+    return function();
+  }
+};
+
+} // namespace adapt
+
+#endif
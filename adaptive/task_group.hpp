@@ -0,0 +1,114 @@
+#pragma once
+
+#ifndef _TASK_GROUP_HPP_
+#define _TASK_GROUP_HPP_
+
+#include "adaptive.hpp"
+
+#include <atomic>
+#include <type_traits>
+#include <utility>
+
+namespace adapt {
+
+/*
+ * Class: task_group
+ * ---------------------------
+ *   Fork-join tasks on the threads of the pool active when the group is built (the global one, or the arena of
+ *   task_arena::execute). run() queues a task on the current thread, wait() executes queued tasks until every task of
+ *   the group has finished. Threads done with their share of a loop steal queued tasks, so tasks spawned inside loop
+ *   bodies spread over the idle threads; tasks spawned outside loops start running at wait(), as the pool sleeps
+ *   between loops. Tasks may run more tasks and wait on groups of their own.
+ *
+ *     int fib(int n) {
+ *       if (n < 2) return n;
+ *       int a, b;
+ *       adapt::task_group group;
+ *       group.run([&]() { a = fib(n - 1); });
+ *       b = fib(n - 2);
+ *       group.wait();
+ *       return a + b;
+ *     }
+ */
+class task_group {
+  std::atomic<size_t> _pending; // tasks run and not finished
+  __internal__::ThreadHandler *_handler;
+
+  // Executes queued tasks, of any group, until the ones of this group are over
+  void drain() {
+    using namespace __internal__;
+    auto done = [this]() { return this->_pending.load(std::memory_order_acquire) == 0; };
+    while (!done())
+      if (!this->_handler->tasks.execute_one(size_t(current_thread_id)) && !this->_handler->help_nested())
+        this->_handler->wait_for(done); // remaining tasks are running on other threads
+  }
+
+public:
+  task_group() : _pending(0), _handler(&__internal__::active_handler()) {}
+  task_group(const task_group &) = delete;
+  task_group &operator=(const task_group &) = delete;
+  ~task_group() { this->wait(); }
+
+  /*
+   * Method: run
+   * ---------------------------
+   *   Queues a copy of function, called with no arguments by some thread of the pool.
+   */
+  template <class Function>
+  void run(Function &&function) {
+    using namespace __internal__;
+    using task_t = Task<typename std::decay<Function>::type>;
+    this->_pending++;
+    const size_t id = (current_handler == this->_handler) ? size_t(current_thread_id) : 0;
+    this->_handler->tasks.push(id, new task_t(std::forward<Function>(function), this->_pending));
+  }
+
+  /*
+   * Method: wait
+   * ---------------------------
+   *   Returns once every task run on the group has finished, executing tasks meanwhile. Outside the loops of the
+   *   pool, it launches one on the pool so its threads execute the tasks too.
+   */
+  void wait() {
+    using namespace __internal__;
+    if (this->_pending.load(std::memory_order_acquire) == 0) return;
+    if (current_handler == this->_handler) {
+      this->drain();
+      return;
+    }
+    ArenaScope scope(*this->_handler); // from another pool or outside loops
+    parallel_for(0, 1, [this](const int, const int) { this->drain(); });
+  }
+};
+
+namespace __internal__ // anonymous namespace
+{
+
+inline void run_each(task_group &) {}
+
+template <class Function, class... Functions>
+void run_each(task_group &group, const Function &function, const Functions &... functions) {
+  group.run([&function]() { function(); });
+  run_each(group, functions...);
+}
+
+} // namespace __internal__
+
+/*
+ * Function: adapt::parallel_invoke
+ * ---------------------------
+ *   Calls every function as a task of a group of its own, in parallel on the threads of the active pool, and
+ *   returns once every call has returned.
+ *
+ *     adapt::parallel_invoke([&]() { build(left); }, [&]() { build(right); });
+ */
+template <class... Functions>
+void parallel_invoke(const Functions &... functions) {
+  task_group group;
+  __internal__::run_each(group, functions...);
+  group.wait();
+}
+
+} // namespace adapt
+
+#endif
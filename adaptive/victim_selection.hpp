@@ -0,0 +1,236 @@
+#pragma once
+
+#ifndef _VICTIM_SELECTION_HPP_
+#define _VICTIM_SELECTION_HPP_
+
+#include "_defines.hpp"
+#include "_topology.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace adapt {
+
+/*
+ * Victim selection policies
+ * ---------------------------
+ *   A victim selector chooses which sub-ranges a thief inspects on extract_par. Each worker owns a copy of the
+ *   selector from the loop policy, initialized with init(id, nthr) when the worker is built. Each steal attempt calls
+ *   begin(), then next(visited, remaining) until a steal succeeds or every victim was visited, where:
+ *
+ *      visited : victims already inspected (or the thief itself) on the current attempt
+ *    remaining : callable, remaining(i) estimates how many iterations victim i still has
+ *
+ *   next must return an unvisited victim, and there is always at least one when it is called.
+ */
+typedef std::array<bool, ADPT_MAX_THREADS> visited_t;
+
+namespace __internal__ // anonymous namespace
+{
+
+// Non-zero seed, different for each thread and each loop
+inline uint32_t xorshift_seed(const size_t id) {
+  const uint64_t ticks = std::chrono::steady_clock::now().time_since_epoch().count();
+  return uint32_t((id + 1) * 0x9E3779B9u ^ ticks ^ (ticks >> 32)) | 1u;
+}
+
+inline uint32_t xorshift(uint32_t &state) {
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+} // namespace __internal__
+
+/*
+ * Class: xorshift_victim
+ * ---------------------------
+ *   Random victim from a per-worker xorshift generator, then the next unvisited one.
+ */
+class xorshift_victim {
+  uint32_t _state;
+  size_t _nthr;
+
+public:
+  void init(const size_t id, const size_t nthr) {
+    this->_state = __internal__::xorshift_seed(id);
+    this->_nthr  = nthr;
+  }
+
+  void begin() {}
+
+  template <class Remaining>
+  size_t next(const visited_t &visited, const Remaining &) {
+    size_t i;
+    for (i = __internal__::xorshift(this->_state) % this->_nthr; visited[i]; i = (i + 1) % this->_nthr)
+      ; // Advances to an unvisited victim/sub-range
+    return i;
+  }
+};
+
+/*
+ * Class: round_robin_victim
+ * ---------------------------
+ *   Victims in circular order, resuming after the last victim inspected on a previous attempt.
+ */
+class round_robin_victim {
+  size_t _cursor;
+  size_t _nthr;
+
+public:
+  void init(const size_t id, const size_t nthr) {
+    this->_cursor = id;
+    this->_nthr   = nthr;
+  }
+
+  void begin() {}
+
+  template <class Remaining>
+  size_t next(const visited_t &visited, const Remaining &) {
+    do {
+      this->_cursor = (this->_cursor + 1) % this->_nthr;
+    } while (visited[this->_cursor]);
+    return this->_cursor;
+  }
+};
+
+/*
+ * Class: nearest_victim
+ * ---------------------------
+ *   Closest threads first (id + 1, id - 1, id + 2, ...). With the initial even distribution, neighbouring threads own
+ *   adjacent sub-ranges, so stolen iterations stay contiguous with the ones the thief executed before.
+ */
+class nearest_victim {
+  size_t _id;
+  size_t _nthr;
+
+public:
+  void init(const size_t id, const size_t nthr) {
+    this->_id   = id;
+    this->_nthr = nthr;
+  }
+
+  void begin() {}
+
+  template <class Remaining>
+  size_t next(const visited_t &visited, const Remaining &) {
+    for (size_t d = 1;; d++) {
+      if ((this->_id + d < this->_nthr) && !visited[this->_id + d]) return this->_id + d;
+      if ((this->_id >= d) && !visited[this->_id - d]) return this->_id - d;
+    }
+  }
+};
+
+/*
+ * Class: richest_victim
+ * ---------------------------
+ *   Unvisited victim with the most remaining iterations, as published by its sub-range bounds. Scans every victim on
+ *   each pick, so it trades inspection traffic for bigger steals.
+ */
+class richest_victim {
+  size_t _nthr;
+
+public:
+  void init(const size_t, const size_t nthr) { this->_nthr = nthr; }
+
+  void begin() {}
+
+  template <class Remaining>
+  size_t next(const visited_t &visited, const Remaining &remaining) {
+    size_t richest = this->_nthr;
+    size_t most    = 0;
+    for (size_t i = 0; i < this->_nthr; i++) {
+      if (visited[i]) continue;
+      const size_t work = static_cast<size_t>(remaining(i));
+      if ((richest == this->_nthr) || (work > most)) {
+        richest = i;
+        most    = work;
+      }
+    }
+    return richest;
+  }
+};
+
+/*
+ * Class: hierarchical_victim
+ * ---------------------------
+ *   Topology-aware random victims. Each steal attempt first inspects threads sharing the thief's last level cache,
+ *   then threads on its NUMA node, and only then remote threads. The effort on the first two levels (victims
+ *   inspected before moving to the next level) is configurable; the last level is always exhausted. Default policy.
+ *
+ *   cache_effort : victims inspected among threads sharing the last level cache
+ *    node_effort : victims inspected among the other threads of the NUMA node
+ */
+class hierarchical_victim {
+  uint32_t _state;
+  size_t _nthr;
+  const uint16_t *_order;                             // other threads, closest first
+  size_t _end[__internal__::Topology::NUM_LEVELS];    // end of each level on _order
+  size_t _effort[__internal__::Topology::NUM_LEVELS]; // victims to inspect on each level
+  size_t _level;                                      // level of the current steal attempt
+  size_t _tries;                                      // victims inspected on the current level
+
+  // Random unvisited victim on _order[begin, end), or _nthr if there is none
+  size_t pick(const size_t begin, const size_t end, const visited_t &visited) {
+    if (begin == end) return this->_nthr;
+    const size_t start = begin + __internal__::xorshift(this->_state) % (end - begin);
+    size_t i           = start;
+    do {
+      if (!visited[this->_order[i]]) return this->_order[i];
+      if (++i == end) i = begin;
+    } while (i != start);
+    return this->_nthr;
+  }
+
+public:
+  hierarchical_victim(const size_t cache_effort = ADPT_MAX_THREADS, const size_t node_effort = ADPT_MAX_THREADS) {
+    this->_effort[__internal__::Topology::CACHE]  = cache_effort;
+    this->_effort[__internal__::Topology::NODE]   = node_effort;
+    this->_effort[__internal__::Topology::SYSTEM] = ADPT_MAX_THREADS;
+  }
+
+  void init(const size_t id, const size_t nthr) {
+    using __internal__::Topology;
+    const Topology &topology = __internal__::get_topology();
+    this->_state             = __internal__::xorshift_seed(id);
+    this->_nthr              = nthr;
+    if (topology.num_threads() == nthr) {
+      this->_order = topology.neighbours(id);
+      for (int level = 0; level < Topology::NUM_LEVELS; level++)
+        this->_end[level] = topology.level_end(id, Topology::Level(level));
+    } else { // loop does not run on the scheduler threads: no topology, any victim
+      this->_order = nullptr;
+      for (int level = 0; level < Topology::NUM_LEVELS; level++) this->_end[level] = 0;
+    }
+  }
+
+  void begin() {
+    this->_level = 0;
+    this->_tries = 0;
+  }
+
+  template <class Remaining>
+  size_t next(const visited_t &visited, const Remaining &) {
+    using __internal__::Topology;
+    if (this->_order) {
+      for (; this->_level < Topology::NUM_LEVELS; this->_level++, this->_tries = 0) {
+        if (this->_tries >= this->_effort[this->_level]) continue;
+        const size_t victim = this->pick(0, this->_end[this->_level], visited);
+        if (victim < this->_nthr) {
+          this->_tries++;
+          return victim;
+        }
+      }
+    }
+    size_t i; // every level exhausted: any unvisited victim
+    for (i = __internal__::xorshift(this->_state) % this->_nthr; visited[i]; i = (i + 1) % this->_nthr)
+      ;
+    return i;
+  }
+};
+
+} // namespace adapt
+
+#endif
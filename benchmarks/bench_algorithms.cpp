@@ -0,0 +1,131 @@
+/*
+ * Benchmark: adaptive parallel algorithms against std::execution::par
+ * ---------------------------
+ *   Runs for_each, transform, transform_reduce, count_if, find_if and any_of (match at the middle of the sequence),
+ *   inclusive_scan and sort over a vector of doubles, with adapt:: and with the standard parallel algorithms of the
+ *   C++17 library (libstdc++ runs them on TBB), and reports the best time of each in milliseconds. libc++ has no
+ *   parallel algorithms: bench_algorithms only reports the adaptive times, bench_algorithms_std (make
+ *   bench_algorithms_std, with TBB installed) is built against libstdc++ and runs both.
+ *
+ *   usage: bench_algorithms [elements] [repetitions]
+ */
+#include "../adaptive/algorithm.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#if defined(__cpp_lib_parallel_algorithm)
+#include <execution>
+#define HAS_STD_PAR 1
+#else
+#define HAS_STD_PAR 0
+#endif
+
+typedef std::chrono::steady_clock bench_clock;
+
+// Best time of repetitions runs of function, in milliseconds
+template <class Function>
+static double best_ms(const size_t repetitions, const Function &function) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t r = 0; r < repetitions; r++) {
+    const bench_clock::time_point start = bench_clock::now();
+    function();
+    best = std::min(best, std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+  }
+  return best;
+}
+
+static void report(const char *name, const double adaptive, const double standard) {
+  if (HAS_STD_PAR)
+    printf("%18s %12.3lf %12.3lf %10.2lf\n", name, adaptive, standard, standard / adaptive);
+  else
+    printf("%18s %12.3lf %12s %10s\n", name, adaptive, "-", "-");
+}
+
+int main(int argc, char *argv[]) {
+  const size_t n           = (argc > 1) ? static_cast<size_t>(atol(argv[1])) : 1 << 24;
+  const size_t repetitions = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 10;
+  std::vector<double> in(n), out(n);
+  std::iota(in.begin(), in.end(), 0.0);
+  const double middle = double(n / 2);
+
+  auto heavy  = [](const double x) { return std::sqrt(x) * std::sin(x); };
+  auto update = [](double &x) { x = std::sqrt(x + 1.0); };
+  auto even   = [](const double x) { return std::fmod(x, 2.0) == 0.0; };
+  auto match  = [middle](const double x) { return x == middle; };
+  double sink = 0.0; // keeps results alive
+
+  printf("%zu threads, %zu elements, best of %zu\n", adapt::get_num_threads(), n, repetitions);
+  printf("%18s %12s %12s %10s\n", "algorithm", "adapt (ms)", "std (ms)", "speedup");
+
+  double standard = 0.0;
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() { std::for_each(std::execution::par, out.begin(), out.end(), update); });
+#endif
+  report("for_each", best_ms(repetitions, [&]() { adapt::for_each(out.begin(), out.end(), update); }), standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions,
+                     [&]() { std::transform(std::execution::par, in.begin(), in.end(), out.begin(), heavy); });
+#endif
+  report("transform", best_ms(repetitions, [&]() { adapt::transform(in.begin(), in.end(), out.begin(), heavy); }),
+         standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() {
+    sink += std::transform_reduce(std::execution::par, in.begin(), in.end(), 0.0, std::plus<double>(), heavy);
+  });
+#endif
+  report("transform_reduce", best_ms(repetitions, [&]() {
+           sink += adapt::transform_reduce(in.begin(), in.end(), 0.0, std::plus<double>(), heavy);
+         }),
+         standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() { sink += std::count_if(std::execution::par, in.begin(), in.end(), even); });
+#endif
+  report("count_if", best_ms(repetitions, [&]() { sink += adapt::count_if(in.begin(), in.end(), even); }), standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() { sink += *std::find_if(std::execution::par, in.begin(), in.end(), match); });
+#endif
+  report("find_if", best_ms(repetitions, [&]() { sink += *adapt::find_if(in.begin(), in.end(), match); }), standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() { sink += std::any_of(std::execution::par, in.begin(), in.end(), match); });
+#endif
+  report("any_of", best_ms(repetitions, [&]() { sink += adapt::any_of(in.begin(), in.end(), match); }), standard);
+
+#if HAS_STD_PAR
+  standard = best_ms(repetitions,
+                     [&]() { std::inclusive_scan(std::execution::par, in.begin(), in.end(), out.begin()); });
+#endif
+  report("inclusive_scan", best_ms(repetitions, [&]() {
+           adapt::inclusive_scan(in.begin(), in.end(), out.begin(), std::plus<double>());
+         }),
+         standard);
+
+  std::vector<double> keys(n);
+  for (size_t i = 0; i < n; i++) keys[i] = heavy(double(i)); // scrambled
+#if HAS_STD_PAR
+  standard = best_ms(repetitions, [&]() {
+    out = keys;
+    std::sort(std::execution::par, out.begin(), out.end());
+  });
+#endif
+  report("sort", best_ms(repetitions, [&]() {
+           out = keys;
+           adapt::parallel_sort(out.begin(), out.end());
+         }),
+         standard);
+
+  printf("(%lg)\n", sink);
+  return 0;
+}
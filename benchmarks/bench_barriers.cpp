@@ -0,0 +1,69 @@
+/*
+ * Microbenchmark: barrier scaling
+ * ---------------------------
+ *   Every algorithm of make_barrier runs back-to-back barriers on 2, 4, 8, ... threads (up to the scheduler's number
+ *   of threads), pinned like the scheduler's, and reports the time of one barrier. Threads never sleep (infinite spin)
+ *   so only the synchronization itself is measured.
+ *
+ *   usage: bench_barriers [barriers per measure]
+ */
+#include "../adaptive/adaptive.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <pthread.h>
+#include <thread>
+#include <vector>
+
+static double run(adapt::Barrier &barrier, const size_t num_threads, const size_t iters) {
+  const adapt::__internal__::Topology &topology = adapt::__internal__::get_topology();
+  std::vector<std::thread> threads;
+  std::chrono::steady_clock::time_point start, end;
+
+  barrier.set_participants(num_threads);
+  barrier.set_spin(std::numeric_limits<uint64_t>::max());
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(topology.cpu(t), &cpuset);
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+
+      barrier.wait(t); // warm up
+      if (t == 0) start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < iters; i++) barrier.wait(t);
+      if (t == 0) end = std::chrono::steady_clock::now();
+    });
+  }
+  for (std::thread &t : threads) t.join();
+  return std::chrono::duration<double, std::nano>(end - start).count() / iters;
+}
+
+int main(int argc, char *argv[]) {
+  const size_t iters       = (argc > 1) ? static_cast<size_t>(atoi(argv[1])) : 100000;
+  const size_t num_threads = adapt::get_num_threads();
+  const char *names[]      = {"central", "tree", "dissemination", "topology"};
+
+  adapt::stop_workers(); // keep the scheduler threads out of the measurement
+
+  printf("%zu barriers per measure, ns per barrier\n", iters);
+  printf("%8s", "threads");
+  for (const char *name : names) printf(" %14s", name);
+  printf("\n");
+
+  for (size_t n = MIN(size_t(2), num_threads);; n = MIN(n << 1, num_threads)) {
+    printf("%8zu", n);
+    for (const char *name : names) {
+      std::unique_ptr<adapt::Barrier> barrier(adapt::make_barrier(name, adapt::__internal__::get_topology()));
+      printf(" %14.1lf", run(*barrier, n, iters));
+      fflush(stdout);
+    }
+    printf("\n");
+    if (n == num_threads) break;
+  }
+
+  return 0;
+}
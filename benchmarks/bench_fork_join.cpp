@@ -0,0 +1,69 @@
+/*
+ * Microbenchmark: fork/join latency against idle CPU burn
+ * ---------------------------
+ *   Runs empty parallel loops with several spin times of the scheduler barrier (ADAPT_BARRIER) and reports:
+ *     - hot: latency of back-to-back loops, when the workers are still spinning;
+ *     - cold: latency of a loop issued after the pool sat idle for a while, when the workers are sleeping;
+ *     - idle: CPU time burnt by the whole process while the pool sits idle, in cores.
+ *   A spin time of "inf" on the central barrier is the former pure busy-wait barrier.
+ *
+ *   usage: bench_fork_join [idle milliseconds] [loops]
+ */
+#include "../adaptive/adaptive.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <limits>
+#include <thread>
+
+typedef std::chrono::steady_clock bench_clock;
+
+static double cpu_seconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double elapsed_us(const bench_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+static void empty_loop() {
+  adapt::parallel_for(size_t(0), adapt::get_num_threads(), [](size_t, size_t) {});
+}
+
+int main(int argc, char *argv[]) {
+  const double idle_ms = (argc > 1) ? atof(argv[1]) : 200.0;
+  const size_t loops   = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 2000;
+  const uint64_t spins[] = {0, 10000, 100000, 1000000, std::numeric_limits<uint64_t>::max()};
+  adapt::Barrier &barrier = *adapt::__internal__::thread_handler.barrier;
+
+  printf("%zu threads, %zu hot loops, %.0lf ms idle\n", adapt::get_num_threads(), loops, idle_ms);
+  printf("%10s %12s %12s %12s\n", "spin", "hot (us)", "cold (us)", "idle (cores)");
+
+  for (const uint64_t spin : spins) {
+    barrier.set_spin(spin);
+    empty_loop(); // workers pick the new spin time up
+
+    bench_clock::time_point start = bench_clock::now();
+    for (size_t i = 0; i < loops; i++) empty_loop();
+    const double hot = elapsed_us(start) / loops;
+
+    const double cpu_start = cpu_seconds();
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(idle_ms));
+    const double idle = (cpu_seconds() - cpu_start) / (idle_ms * 1e-3);
+
+    start = bench_clock::now();
+    empty_loop();
+    const double cold = elapsed_us(start);
+
+    if (spin == std::numeric_limits<uint64_t>::max())
+      printf("%10s %12.2lf %12.2lf %12.2lf\n", "inf", hot, cold, idle);
+    else
+      printf("%8.0lfus %12.2lf %12.2lf %12.2lf\n", spin * 1e-3, hot, cold, idle);
+  }
+
+  return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Benchmark: cost of deterministic reductions
+ * ---------------------------
+ *   Sums a vector of doubles with parallel_reduce (default policy, then auto_grain) and with
+ *   parallel_deterministic_reduce (default blocks), and reports the best time of each in milliseconds and whether each
+ *   gave the same bits on every repetition.
+ *
+ *   usage: bench_reduce [elements] [repetitions]
+ */
+#include "../adaptive/adaptive.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <vector>
+
+typedef std::chrono::steady_clock bench_clock;
+typedef adapt::policy<adapt::default_victim, adapt::default_distribution, adapt::auto_grain> auto_policy;
+
+int main(int argc, char *argv[]) {
+  const size_t n           = (argc > 1) ? static_cast<size_t>(atol(argv[1])) : 1 << 24;
+  const size_t repetitions = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 20;
+  std::vector<double> v(n);
+  for (size_t i = 0; i < n; i++) v[i] = 1.0 / double(i + 1);
+  auto sum = [&v](const size_t b, const size_t e, double value) {
+    for (size_t i = b; i < e; i++) value += v[i];
+    return value;
+  };
+
+  printf("%zu threads, %zu elements, best of %zu\n", adapt::get_num_threads(), n, repetitions);
+  printf("%16s %12s %14s\n", "reduction", "time (ms)", "reproducible");
+
+  const char *names[] = {"parallel_reduce", "auto_grain", "deterministic"};
+  for (int mode = 0; mode < 3; mode++) {
+    double best = std::numeric_limits<double>::max(), first = 0.0;
+    bool same = true;
+    for (size_t r = 0; r < repetitions; r++) {
+      const bench_clock::time_point start = bench_clock::now();
+      double value                        = 0.0;
+      if (mode == 0) value = adapt::parallel_reduce(size_t(0), n, 0.0, sum, std::plus<double>());
+      if (mode == 1) value = adapt::parallel_reduce(size_t(0), n, 0.0, sum, std::plus<double>(), auto_policy());
+      if (mode == 2) value = adapt::parallel_deterministic_reduce(size_t(0), n, 0.0, sum, std::plus<double>());
+      best = std::min(best, std::chrono::duration<double, std::milli>(bench_clock::now() - start).count());
+      if (r == 0) first = value;
+      same = same && (value == first);
+    }
+    printf("%16s %12.3lf %14s\n", names[mode], best, same ? "yes" : "no");
+  }
+  return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Microbenchmark: worker layout and coherence traffic
+ * ---------------------------
+ *   Every thread owns a worker and runs the access pattern of the THE protocol: the owner writes `first` and reads
+ *   `last` on each extraction, while it periodically acts as a thief on a random victim (reads `first`/`last`, takes
+ *   the lock and moves `last`). The same pattern runs on two layouts:
+ *     - packed: the fields of the original Worker, with workers of neighbouring threads allocated back to back;
+ *     - padded: the library's own workers, built on its WorkerArena (owner, owner-to-thief and thief-to-owner lines
+ *       split).
+ *
+ *   usage: bench_worker_layout [seconds per layout] [extractions per steal attempt]
+ *
+ *   The reported extraction rate is a proxy for coherence traffic. To count it directly, run under
+ *     perf stat -e cache-misses,LLC-load-misses,offcore_response.demand_rfo.l3_miss.snoop_hitm ./bench_worker_layout
+ *   or `perf c2c record/report`, which lists the contended lines (HITM) of each layout.
+ */
+#include "../adaptive/adaptive.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+struct PackedWorker {
+  std::atomic<size_t> first;
+  std::atomic<size_t> last;
+  size_t copy_first;
+  size_t seq_chunk;
+  size_t min_steal;
+  size_t half_range;
+  adapt::AtomicMutex lock;
+};
+
+static auto empty_body = [](size_t, size_t) {};
+typedef adapt::__internal__::ForWorker<size_t, decltype(empty_body)> PaddedWorker;
+
+template <class WorkerT>
+double run(std::vector<WorkerT *> &workers, const double seconds, const size_t steal_period) {
+  const size_t num_threads = workers.size();
+  std::vector<size_t> extractions(num_threads * (ADPT_CACHE_LINE / sizeof(size_t)), 0);
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> threads;
+
+  for (WorkerT *w : workers) {
+    w->first = w->copy_first = 0;
+    w->last                  = ~size_t(0);
+    w->seq_chunk             = 1;
+  }
+
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      WorkerT &self  = *workers[t];
+      unsigned state = t + 1;
+      size_t count   = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (size_t i = 0; i < steal_period; i++) { // owner: extract_seq fast path
+          const size_t next = self.copy_first + self.seq_chunk;
+          self.first        = next;
+          if (next < self.last) self.copy_first = next;
+          count++;
+        }
+        state ^= state << 13; // thief: extract_par on a random victim
+        state ^= state >> 17;
+        state ^= state << 5;
+        WorkerT &victim = *workers[state % num_threads];
+        if ((&victim != &self) && (victim.last > victim.first) && victim.lock.try_lock()) {
+          victim.last = victim.last - 1;
+          victim.lock.unlock();
+        }
+      }
+      extractions[t * (ADPT_CACHE_LINE / sizeof(size_t))] = count;
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop = true;
+  for (std::thread &t : threads) t.join();
+
+  size_t total = 0;
+  for (size_t t = 0; t < num_threads; t++) total += extractions[t * (ADPT_CACHE_LINE / sizeof(size_t))];
+  return total / seconds;
+}
+
+int main(int argc, char *argv[]) {
+  const double seconds      = (argc > 1) ? atof(argv[1]) : 2.0;
+  const size_t steal_period = (argc > 2) ? static_cast<size_t>(atoi(argv[2])) : 16;
+  const size_t num_threads  = adapt::get_num_threads();
+
+  adapt::stop_workers(); // keep the scheduler threads out of the measurement
+
+  printf("%zu threads, %.1lf s per layout, 1 steal attempt every %zu extractions\n", num_threads, seconds,
+         steal_period);
+  printf("sizeof packed %zu B, padded %zu B\n", sizeof(PackedWorker), sizeof(PaddedWorker));
+
+  std::vector<PackedWorker> packed_storage(num_threads); // neighbouring workers back to back
+  std::vector<PackedWorker *> packed_workers;
+  for (PackedWorker &w : packed_storage) packed_workers.push_back(&w);
+
+  adapt::__internal__::WorkerArena arena;
+  std::vector<PaddedWorker *> padded_workers;
+  arena.reserve(num_threads, sizeof(PaddedWorker), alignof(PaddedWorker));
+  for (size_t t = 0; t < num_threads; t++)
+    padded_workers.push_back(new (arena.slot(t)) PaddedWorker(t, 0, num_threads, nullptr, empty_body));
+
+  const double packed = run(packed_workers, seconds, steal_period);
+  printf("packed : %12.0lf extractions/s\n", packed);
+  const double padded = run(padded_workers, seconds, steal_period);
+  printf("padded : %12.0lf extractions/s (%.2lfx)\n", padded, padded / packed);
+
+  for (PaddedWorker *w : padded_workers) w->~PaddedWorker();
+
+  return 0;
+}
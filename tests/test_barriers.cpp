@@ -4,7 +4,9 @@
 #include "Catch2/catch.hpp"
 
 #include <chrono>
+#include <memory>
 #include <thread>
+#include <vector>
 
 using namespace adapt;
 
@@ -80,4 +82,62 @@ TEST_CASE("is internal resetting counter correctly") {
   for (size_t i = 0; i < num_threads; i++) { threads[i] = std::thread(barrier_loop, std::ref(barrier), iters); }
   for (size_t i = 0; i < num_threads; i++) { threads[i].join(); }
   REQUIRE(barrier.is_free());
-}
\ No newline at end of file
+}
+
+void hybrid_barrier_loop(HybridBarrier &barrier, size_t iters) {
+  for (size_t i = 0; i < iters; i++) { barrier.wait(); }
+}
+
+TEST_CASE("does hybrid barrier wake sleeping threads") {
+  HybridBarrier barrier(2, 0); // never spins
+  std::thread waiting(hybrid_barrier_loop, std::ref(barrier), 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  REQUIRE(!barrier.is_free());
+  barrier.wait();
+  waiting.join();
+  REQUIRE(barrier.is_free());
+}
+
+TEST_CASE("does hybrid barrier run with spinning and sleeping threads") {
+  HybridBarrier barrier;
+  const size_t num_threads = 4;
+  const size_t iters       = 2000;
+  std::thread threads[num_threads];
+  barrier.set_participants(num_threads);
+  barrier.set_spin(1000); // short enough for some rounds to sleep
+  for (size_t i = 0; i < num_threads; i++) { threads[i] = std::thread(hybrid_barrier_loop, std::ref(barrier), iters); }
+  for (size_t i = 0; i < num_threads; i++) { threads[i].join(); }
+  REQUIRE(barrier.is_free());
+}
+
+void checked_barrier_loop(Barrier &barrier, size_t id, size_t num_threads, size_t iters,
+                          std::atomic<size_t> &arrived, std::atomic<size_t> &early) {
+  for (size_t i = 0; i < iters; i++) {
+    arrived++;
+    barrier.wait(id);
+    if (arrived < (i + 1) * num_threads) early++; // someone left before everyone arrived
+    barrier.wait(id);
+  }
+}
+
+TEST_CASE("do scalable barriers hold every thread until the last one arrives") {
+  const size_t iters = 200;
+  for (const std::string name : {"central", "tree", "dissemination", "topology"}) {
+    for (const size_t num_threads : {1, 2, 3, 5, 8, 13}) {
+      std::unique_ptr<Barrier> barrier(make_barrier(name, adapt::__internal__::get_topology()));
+      REQUIRE(barrier);
+      barrier->set_participants(num_threads);
+      barrier->set_spin(1000); // short enough for some rounds to sleep
+      std::atomic<size_t> arrived(0), early(0);
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < num_threads; i++)
+        threads.emplace_back(checked_barrier_loop, std::ref(*barrier), i, num_threads, iters, std::ref(arrived),
+                             std::ref(early));
+      for (std::thread &t : threads) t.join();
+      INFO(name << " barrier with " << num_threads << " threads");
+      CHECK(early == 0);
+      CHECK(arrived == iters * num_threads);
+    }
+  }
+  CHECK(make_barrier("unknown", adapt::__internal__::get_topology()) == nullptr);
+}
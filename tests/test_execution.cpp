@@ -0,0 +1,136 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#define CATCH_CONFIG_CONSOLE_WIDTH 120
+#include "../adaptive/execution.hpp"
+#include "../adaptive/task_group.hpp"
+#include "Catch2/catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace ex = adapt::execution;
+
+TEST_CASE("Senders") {
+  const size_t n = 100000;
+  ex::scheduler pool;
+
+  SECTION("schedule, then and bulk") {
+    auto work = ex::schedule(pool) | ex::then([n]() { return std::vector<int>(n, 0); }) |
+                ex::bulk(n, [](const size_t i, std::vector<int> &v) { v[i] += int(i % 7); }) |
+                ex::then([](std::vector<int> &&v) { return std::accumulate(v.begin(), v.end(), 0l); });
+    long expected = 0;
+    for (size_t i = 0; i < n; i++) expected += long(i % 7);
+    CHECK(std::get<0>(*ex::sync_wait(work)) == expected);
+    CHECK(std::get<0>(*ex::sync_wait(work)) == expected); // senders are reusable
+  }
+
+  SECTION("bulk_chunked hands out adaptive chunks") {
+    std::vector<std::atomic<int>> visits(n);
+    for (auto &v : visits) v = 0;
+    std::atomic<size_t> chunks(0);
+    auto work = ex::just(2) | ex::bulk_chunked(n, [&](const size_t first, const size_t last, int &scale) {
+                  chunks++;
+                  for (size_t i = first; i < last; i++) visits[i] += scale;
+                });
+    CHECK(std::get<0>(*ex::sync_wait(work)) == 2);
+    CHECK(std::count(visits.begin(), visits.end(), 2) == long(n)); // every index once
+    CHECK(chunks >= pool.num_threads());                          // at least one chunk per worker
+    CHECK(chunks < n);                                            // chunks grow past one index
+  }
+
+  SECTION("schedule and bulk complete on the pool threads") {
+    const std::thread::id caller = std::this_thread::get_id();
+    std::thread::id scheduled, bulked;
+    auto schedule_then = ex::schedule(pool) | ex::then([&scheduled]() { scheduled = std::this_thread::get_id(); });
+    auto bulk_then     = ex::just() | ex::bulk(n, [](const size_t) {}) |
+                     ex::then([&bulked]() { bulked = std::this_thread::get_id(); });
+    ex::sync_wait(schedule_then);
+    ex::sync_wait(bulk_then);
+    CHECK((scheduled != caller) == (pool.num_threads() > 1));
+    CHECK((bulked != caller) == (pool.num_threads() > 1));
+  }
+
+  SECTION("on an arena, and nested in a running loop") {
+    adapt::task_arena arena(2);
+    ex::scheduler small = arena.execute([]() { return ex::scheduler(); });
+    CHECK(small.num_threads() == 2);
+    CHECK(small != pool);
+    auto threads = ex::schedule(small) | ex::then([]() { return adapt::get_num_threads(); });
+    CHECK(std::get<0>(*ex::sync_wait(threads)) == 2);
+
+    std::atomic<size_t> visits(0);
+    adapt::parallel_for(0, 8, [&](const int b, const int e) {
+      for (int i = b; i < e; i++)
+        ex::sync_wait(ex::schedule(pool) | ex::bulk(n, [&visits](const size_t) { visits++; }));
+    });
+    CHECK(visits == 8 * n);
+  }
+
+  SECTION("errors of then functions are rethrown") {
+    auto failing = ex::just() | ex::then([]() -> int { throw std::runtime_error("failed"); }) |
+                   ex::then([](int value) { return value + 1; });
+    CHECK_THROWS_AS(ex::sync_wait(failing), std::runtime_error);
+  }
+}
+
+#if ADPT_HAS_COROUTINES
+// Coroutine started at once, keeping its result until the end of the object
+struct eager_task {
+  struct promise_type {
+    long value = 0;
+    std::atomic<bool> finished{false};
+
+    // Flags the end once the coroutine is suspended for good, for the thread waiting in get()
+    struct final_awaiter {
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+        handle.promise().finished.store(true, std::memory_order_release);
+      }
+      void await_resume() noexcept {}
+    };
+
+    eager_task get_return_object() { return eager_task{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+    std::suspend_never initial_suspend() { return {}; }
+    final_awaiter final_suspend() noexcept { return {}; }
+    void return_value(const long result) { this->value = result; }
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  std::coroutine_handle<promise_type> handle;
+  ~eager_task() { this->handle.destroy(); }
+  long get() const {
+    while (!this->handle.promise().finished.load(std::memory_order_acquire)) std::this_thread::yield();
+    return this->handle.promise().value;
+  }
+};
+
+// Holds the pool until released, so that the coroutine suspends before the sender completes
+static eager_task sum_of_squares(const ex::scheduler pool, const size_t n, const std::atomic<bool> &released,
+                                 std::thread::id &resumed_on) {
+  auto hold = [&released]() {
+    while (!released.load(std::memory_order_acquire)) std::this_thread::yield();
+  };
+  std::vector<long> v = co_await(ex::schedule(pool) | ex::then([n, hold]() {
+                                   hold();
+                                   return std::vector<long>(n);
+                                 }) |
+                                 ex::bulk(n, [](const size_t i, std::vector<long> &v) { v[i] = long(i * i); }));
+  resumed_on = std::this_thread::get_id();
+  co_await ex::schedule(pool); // already on the pool: goes on at once
+  co_return std::accumulate(v.begin(), v.end(), 0l);
+}
+
+TEST_CASE("Awaiting Senders") {
+  const size_t n = 1000;
+  ex::scheduler pool;
+  std::thread::id resumed_on;
+  std::atomic<bool> released(pool.num_threads() == 1); // a single thread completes inline, without suspending
+  eager_task task = sum_of_squares(pool, n, released, resumed_on);
+  released.store(true, std::memory_order_release);
+  CHECK(task.get() == long(n - 1) * n * (2 * n - 1) / 6);
+  CHECK((resumed_on != std::this_thread::get_id()) == (pool.num_threads() > 1)); // suspended, resumed on the pool
+}
+#endif
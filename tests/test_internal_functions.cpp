@@ -1,9 +1,19 @@
 #define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
 #define CATCH_CONFIG_CONSOLE_WIDTH 120
 #include "../adaptive/adaptive.hpp"
+#include "../adaptive/algorithm.hpp"
+#include "../adaptive/cancellation_token.hpp"
+#include "../adaptive/enumerable_thread_specific.hpp"
+#include "../adaptive/task_group.hpp"
 #include "Catch2/catch.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <numeric>
 #include <thread>
+#include <vector>
 
 static auto for_compute       = [](const int b, const int e) {};
 static auto reduction_compute = [](const int b, const int e, int i) { return i; };
@@ -11,19 +21,20 @@ typedef std::__1::plus<int> plus_int;
 typedef decltype(for_compute) for_body;
 typedef decltype(reduction_compute) red_body;
 
+// Workers are cache-line aligned: built on arena slots, as by the loops
 static adapt::__internal__::ForWorker<int, for_body> *
-create_dumb_forworker(const int id, const int first, const int last) {
+create_dumb_forworker(adapt::__internal__::WorkerArena &arena, const int id, const int first, const int last) {
   using namespace adapt::__internal__;
   using forworker_t = ForWorker<int, for_body>;
-  return new forworker_t(id, first, last, nullptr, for_compute);
+  return new (arena.slot(id)) forworker_t(id, first, last, nullptr, for_compute);
 }
 
 static adapt::__internal__::ReductionWorker<int, red_body, int, plus_int> *
-create_dumb_reductionworker(const int id, const int first, const int last) {
+create_dumb_reductionworker(adapt::__internal__::WorkerArena &arena, const int id, const int first, const int last) {
   using namespace adapt::__internal__;
   plus_int reductor = std::plus<int>();
   using redworker_t = ReductionWorker<int, red_body, int, plus_int>;
-  return new redworker_t(id, first, last, 0, nullptr, reduction_compute, reductor);
+  return new (arena.slot(id)) redworker_t(id, first, last, 0, nullptr, reduction_compute, reductor);
 }
 
 TEST_CASE("Get Number of Threads") {
@@ -64,9 +75,47 @@ TEST_CASE("Thread Handler Object") {
     CHECK(passed);
   }
 
+  SECTION("is the worker arena reused between loops") {
+    std::vector<WorkerInterface *> previous(th.workers_array.begin(), th.workers_array.begin() + num_threads);
+    adapt::parallel_for(0, 1, [](const int b, const int e) {});
+    bool passed = true;
+    for (int i = 0; (i < num_threads) && passed; i++) {
+      passed = (th.workers_array[i] == previous[i]);
+      passed = passed && ((reinterpret_cast<uintptr_t>(th.workers_array[i]) % ADPT_CACHE_LINE) == 0);
+    }
+    CHECK(passed);
+  }
+
+  SECTION("does the topology sort every other thread by distance") {
+    const Topology &topology = th.topology;
+    bool passed              = (topology.num_threads() == num_threads);
+    for (size_t t = 0; (t < num_threads) && passed; t++) {
+      std::vector<bool> seen(num_threads, false);
+      const uint16_t *neighbours = topology.neighbours(t);
+      for (size_t n = 0; n + 1 < num_threads; n++) seen[neighbours[n]] = true;
+      passed = !seen[t] && (std::count(seen.begin(), seen.end(), true) == num_threads - 1);
+      passed = passed && (topology.level_end(t, Topology::CACHE) <= topology.level_end(t, Topology::NODE));
+      passed = passed && (topology.level_end(t, Topology::SYSTEM) == num_threads - 1);
+      for (size_t n = 0; n < topology.level_end(t, Topology::CACHE); n++)
+        passed = passed && (topology.domain(neighbours[n], Topology::CACHE) == topology.domain(t, Topology::CACHE));
+      CHECK(CPU_ISSET(topology.cpu(t), &th.cpusets[t]));
+    }
+    CHECK(passed);
+  }
+
+  SECTION("are core classes coherent with the measured alpha") {
+    size_t num_little = 0;
+    for (size_t t = 0; t < num_threads; t++) num_little += th.topology.is_little(t);
+    CHECK(num_little < num_threads); // there is always a biggest core
+    CHECK(((num_little == 0) == (th.topology.alpha() == 1)));
+    CHECK(!th.topology.is_little(num_threads)); // outside the pool
+  }
+
   SECTION("destructing object") {
-    ThreadHandler *nth = new ThreadHandler();
-    delete nth;
+    WorkerArena storage; // cache-line aligned, as by task_arena
+    storage.reserve(1, sizeof(ThreadHandler), alignof(ThreadHandler));
+    ThreadHandler *nth = new (storage.slot(0)) ThreadHandler();
+    nth->~ThreadHandler();
   }
 }
 
@@ -76,8 +125,10 @@ TEST_CASE("For Workers") {
   size_t num_threads = adapt::get_num_threads();
   const int first = 0, last = num_threads;
 
+  WorkerArena arena;
+  arena.reserve(num_threads, sizeof(ForWorker<int, for_body>), alignof(ForWorker<int, for_body>));
   std::vector<ForWorker<int, for_body> *> workers(num_threads, nullptr);
-  for (size_t i = 0; i < num_threads; i++) workers[i] = create_dumb_forworker(i, first, last);
+  for (size_t i = 0; i < num_threads; i++) workers[i] = create_dumb_forworker(arena, i, first, last);
 
   SECTION("checking internals after initialization") {
     const int chunk  = (last - first) / num_threads; // size of initial sub-range (integer division)
@@ -88,7 +139,7 @@ TEST_CASE("For Workers") {
       CHECK(worker->last == worker->first + chunk + static_cast<int>(i < remain)); // last (+1) iteration of sub-range
       CHECK(worker->seq_chunk == get_grain()); // chunk/grain size to serial extraction
       CHECK(worker->min_steal == MAX(int(std::sqrt(worker->last - worker->first)), 1)); // minimal size to steal
-      delete worker;
+      worker->~ForWorker();
     }
   }
 }
@@ -99,8 +150,11 @@ TEST_CASE("Reduction Workers") {
   size_t num_threads = adapt::get_num_threads();
   const int first = 0, last = num_threads;
 
-  std::vector<ReductionWorker<int, red_body, int, std::__1::plus<int>> *> workers(num_threads, nullptr);
-  for (size_t i = 0; i < num_threads; i++) workers[i] = create_dumb_reductionworker(i, first, last);
+  typedef ReductionWorker<int, red_body, int, std::__1::plus<int>> redworker_t;
+  WorkerArena arena;
+  arena.reserve(num_threads, sizeof(redworker_t), alignof(redworker_t));
+  std::vector<redworker_t *> workers(num_threads, nullptr);
+  for (size_t i = 0; i < num_threads; i++) workers[i] = create_dumb_reductionworker(arena, i, first, last);
 
   SECTION("checking internals after initialization") {
     int first = 0, last = num_threads;
@@ -113,7 +167,825 @@ TEST_CASE("Reduction Workers") {
       CHECK(worker->seq_chunk == get_grain()); // chunk/grain size to serial extraction
       CHECK(worker->min_steal == MAX(int(std::sqrt(worker->last - worker->first)), 1)); // minimal size to steal
       CHECK(worker->reduction_value == 0);
-      delete worker;
+      worker->~redworker_t();
+    }
+  }
+}
+
+template <class Victim>
+static bool visits_every_victim(const size_t id, const size_t nthr) {
+  adapt::visited_t visited;
+  visited.fill(false);
+  visited[id] = true;
+  Victim victim;
+  victim.init(id, nthr);
+  auto remaining = [](const size_t v) { return v; };
+  for (size_t k = 1; k < nthr; k++) {
+    const size_t i = victim.next(visited, remaining);
+    if ((i >= nthr) || visited[i]) return false;
+    visited[i] = true;
+  }
+  return true;
+}
+
+TEST_CASE("Victim Selection") {
+  const size_t nthr = 8;
+  for (size_t id = 0; id < nthr; id++) {
+    CHECK(visits_every_victim<adapt::xorshift_victim>(id, nthr));
+    CHECK(visits_every_victim<adapt::round_robin_victim>(id, nthr));
+    CHECK(visits_every_victim<adapt::nearest_victim>(id, nthr));
+    CHECK(visits_every_victim<adapt::richest_victim>(id, nthr));
+    CHECK(visits_every_victim<adapt::hierarchical_victim>(id, nthr));
+  }
+
+  SECTION("hierarchical victims on the scheduler threads") {
+    const size_t num_threads = adapt::get_num_threads();
+    for (size_t id = 0; id < num_threads; id++) CHECK(visits_every_victim<adapt::hierarchical_victim>(id, num_threads));
+  }
+
+  SECTION("nearest victims come first") {
+    adapt::visited_t visited;
+    visited.fill(false);
+    visited[3] = true;
+    adapt::nearest_victim victim;
+    victim.init(3, nthr);
+    auto remaining = [](const size_t v) { return v; };
+    CHECK(victim.next(visited, remaining) == 4);
+    visited[4] = true;
+    CHECK(victim.next(visited, remaining) == 2);
+  }
+
+  SECTION("richest victim comes first") {
+    adapt::visited_t visited;
+    visited.fill(false);
+    visited[0] = true;
+    adapt::richest_victim victim;
+    victim.init(0, nthr);
+    auto remaining = [](const size_t v) { return (v == 5) ? 100 : v; };
+    CHECK(victim.next(visited, remaining) == 5);
+  }
+}
+
+TEST_CASE("Scheduling Policies") {
+  using namespace adapt::__internal__;
+  const int first = 0, last = 1 << 12;
+
+  SECTION("demand distribution gives the whole range to thread 0") {
+    typedef adapt::policy<adapt::default_victim, adapt::demand_distribution> policy_t;
+    ForWorker<int, for_body, policy_t> worker0(0, first, last, nullptr, for_compute, policy_t());
+    CHECK(worker0.first == first);
+    CHECK(worker0.last == last);
+    if (adapt::get_num_threads() > 1) {
+      ForWorker<int, for_body, policy_t> worker1(1, first, last, nullptr, for_compute, policy_t());
+      CHECK(worker1.first == worker1.last);
+    }
+  }
+
+  SECTION("grain policies size the sequential extraction") {
+    typedef adapt::policy<adapt::default_victim, adapt::demand_distribution, adapt::log_grain> log_policy_t;
+    ForWorker<int, for_body, log_policy_t> log_worker(0, first, last, nullptr, for_compute, log_policy_t());
+    CHECK(log_worker.seq_chunk == 12);
+
+    typedef adapt::policy<adapt::default_victim, adapt::demand_distribution, adapt::fraction_grain> frac_policy_t;
+    const frac_policy_t frac_policy(adapt::default_victim(), adapt::demand_distribution(), adapt::fraction_grain(16));
+    ForWorker<int, for_body, frac_policy_t> frac_worker(0, first, last, nullptr, for_compute, frac_policy);
+    CHECK(frac_worker.seq_chunk == (last >> 4));
+  }
+
+  SECTION("auto grain converges to the target chunk duration") {
+    adapt::auto_grain grain(10000); // 10 us per chunk
+    int seq_chunk = grain.chunk(last, false);
+    CHECK(seq_chunk == 1);
+    for (int i = 0; i < 10; i++) grain.observe(seq_chunk, seq_chunk, uint64_t(seq_chunk) * 1000); // 1 us/iteration
+    CHECK(seq_chunk == 10);
+    grain.observe(seq_chunk, seq_chunk, uint64_t(seq_chunk) * 100000); // body became 100x slower
+    CHECK(seq_chunk == 5);
+    CHECK(grain.chunk(last, false) == 5); // kept across steals
+  }
+
+  SECTION("learned distribution splits the loop as the last runs did") {
+    LoopHistory *history = get_loop_history(reinterpret_cast<uintptr_t>(&history));
+    history->update(4);
+    CHECK(history->share[0] == Approx(0.25));
+
+    history->executed = {{600, 200, 200, 0}}; // thread 3 executed nothing
+    history->update(4);
+    CHECK(history->share[0] > history->share[1]);
+    CHECK(history->share[3] > 0.0);
+    CHECK(history->bound[4] == 1.0);
+
+    const adapt::learned_distribution distribution(&history);
+    int last_of_previous = first;
+    for (size_t id = 0; id < 4; id++) {
+      int f, l;
+      distribution.range(id, 4, first, last, f, l);
+      CHECK(f == last_of_previous);
+      last_of_previous = l;
+    }
+    CHECK(last_of_previous == last);
+
+    history->update(2); // thread count changed: starts over evenly
+    CHECK(history->share[1] == Approx(0.5));
+
+    adapt::task_arena arena(2); // same site on another pool: a history of its own
+    CHECK(arena.execute([&history]() { return get_loop_history(reinterpret_cast<uintptr_t>(&history)); }) != history);
+  }
+
+  SECTION("affinity partitioner replays the pieces each thread executed") {
+    adapt::affinity_partitioner ap;
+    int64_t f, l;
+    ap.start(2, 0, 100);
+    CHECK_FALSE(ap.replaying());
+    ap.executed(0, 0, 30);
+    ap.executed(0, 30, 50); // consecutive chunks make a single piece
+    ap.executed(1, 50, 80);
+    ap.executed(0, 80, 100); // stolen from thread 1
+
+    ap.start(2, 0, 100);
+    REQUIRE(ap.replaying());
+    CHECK((ap.piece(0, 0, f, l) && f == 0 && l == 50));
+    CHECK((ap.piece(0, 1, f, l) && f == 80 && l == 100));
+    CHECK_FALSE(ap.piece(0, 2, f, l));
+    CHECK((ap.piece(1, 0, f, l) && f == 50 && l == 80));
+
+    const adapt::affinity_distribution distribution(ap);
+    int first0, last0;
+    distribution.range(0, 2, 0, 100, first0, last0);
+    CHECK((first0 == 0 && last0 == 50));
+
+    ap.executed(0, 0, 60);
+    ap.executed(1, 60, 100);
+    ap.start(2, 0, 200); // another range: starts over
+    CHECK_FALSE(ap.replaying());
+  }
+}
+
+TEST_CASE("Nested Loops") {
+  const int domains = 16, cells = 1000;
+
+  SECTION("inner loops run every iteration once") {
+    std::vector<std::atomic<int>> visits(domains * cells);
+    for (auto &v : visits) v = 0;
+    adapt::parallel_for(0, domains, [&](const int b, const int e) {
+      for (int d = b; d < e; d++)
+        adapt::parallel_for(0, cells, [&](const int cb, const int ce) {
+          for (int c = cb; c < ce; c++) visits[d * cells + c]++;
+        });
+    });
+    CHECK(std::count(visits.begin(), visits.end(), 1) == domains * cells);
+  }
+
+  SECTION("inner reductions and deeper nesting") {
+    const long sum = adapt::parallel_reduce(
+      0, domains, 0l,
+      [&](const int b, const int e, long value) {
+        for (int d = b; d < e; d++)
+          value += adapt::parallel_reduce(
+            0, cells, 0l,
+            [&](const int cb, const int ce, long inner) {
+              adapt::parallel_for(cb, ce, [&](const int, const int) {}); // third level
+              for (int c = cb; c < ce; c++) inner += c;
+              return inner;
+            },
+            std::plus<long>());
+        return value;
+      },
+      std::plus<long>());
+    CHECK(sum == long(domains) * (long(cells) * (cells - 1) / 2));
+  }
+}
+
+TEST_CASE("Task Arenas") {
+  const int n = 10000;
+  auto fill   = [n](std::vector<int> &v) {
+    adapt::parallel_for(0, n, [&v](const int b, const int e) {
+      for (int i = b; i < e; i++) v[i]++;
+    });
+  };
+
+  SECTION("loops run on the threads of the arena") {
+    adapt::task_arena arena(2);
+    CHECK(arena.num_threads() == 2);
+    CHECK(arena.execute([]() { return adapt::get_num_threads(); }) == 2);
+    std::vector<int> v(n, 0);
+    arena.execute([&]() { fill(v); });
+    CHECK(std::count(v.begin(), v.end(), 1) == n);
+  }
+
+  SECTION("several threads launch loops on the global pool and on arenas") {
+    adapt::task_arena arena(2);
+    std::vector<std::vector<int>> results(4, std::vector<int>(n, 0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+      threads.emplace_back([&, t]() {
+        for (int rep = 0; rep < 20; rep++) {
+          if (t % 2)
+            arena.execute([&]() { fill(results[t]); });
+          else
+            fill(results[t]);
+        }
+      });
+    for (std::thread &t : threads) t.join();
+    for (const std::vector<int> &v : results) CHECK(std::count(v.begin(), v.end(), 20) == n);
+  }
+
+  SECTION("a learned loop site runs on several pools at once") {
+    using learned_policy = adapt::policy<adapt::default_victim, adapt::learned_distribution>;
+    adapt::task_arena arena(2);
+    std::vector<std::vector<int>> results(2, std::vector<int>(n, 0));
+    auto learned_fill = [n](std::vector<int> &v) {
+      adapt::parallel_for(
+        0, n,
+        [&v](const int b, const int e) {
+          for (int i = b; i < e; i++) v[i]++;
+        },
+        learned_policy(adapt::default_victim(), adapt::learned_distribution(ADAPT_LOOP_SITE)));
+    };
+    std::thread other([&]() {
+      for (int rep = 0; rep < 50; rep++) arena.execute([&]() { learned_fill(results[1]); });
+    });
+    for (int rep = 0; rep < 50; rep++) learned_fill(results[0]);
+    other.join();
+    for (const std::vector<int> &v : results) CHECK(std::count(v.begin(), v.end(), 50) == n);
+  }
+}
+
+TEST_CASE("Blocked Ranges") {
+  using namespace adapt::__internal__;
+
+  SECTION("morton order visits every tile of a grid once") {
+    const size_t count[2] = {5, 3}; // not a power of two: tiles outside the grid are skipped
+    std::vector<int> visits(15, 0);
+    for (size_t i = 0; i < 15; i++) {
+      size_t coord[2];
+      morton_tile(i, count, coord);
+      REQUIRE(coord[0] < 5);
+      REQUIRE(coord[1] < 3);
+      visits[coord[0] * 3 + coord[1]]++;
+    }
+    CHECK(std::count(visits.begin(), visits.end(), 1) == 15);
+  }
+
+  SECTION("aligned groups of tiles are blocks") {
+    const size_t count[2] = {8, 8};
+    for (size_t group = 0; group < 64; group += 4) { // every 4 consecutive tiles make a 2x2 block
+      size_t first[2], coord[2];
+      morton_tile(group, count, first);
+      CHECK(first[0] % 2 == 0);
+      CHECK(first[1] % 2 == 0);
+      for (size_t i = 1; i < 4; i++) {
+        morton_tile(group + i, count, coord);
+        CHECK(coord[0] - first[0] < 2);
+        CHECK(coord[1] - first[1] < 2);
+      }
     }
   }
-}
\ No newline at end of file
+
+  SECTION("loops run on every cell once") {
+    const int rows = 37, cols = 50, pages = 9;
+    std::vector<std::atomic<int>> visits(pages * rows * cols);
+    for (auto &v : visits) v = 0;
+    adapt::parallel_for(adapt::blocked_range2d<int>(0, rows, 4, 0, cols, 8), [&](const adapt::blocked_range2d<int> &r) {
+      for (int i = r.rows().begin(); i < r.rows().end(); i++)
+        for (int j = r.cols().begin(); j < r.cols().end(); j++) visits[i * cols + j]++;
+    });
+    CHECK(std::count(visits.begin(), visits.begin() + rows * cols, 1) == rows * cols);
+
+    auto body3d = [&](const adapt::blocked_range3d<int> &r) {
+      for (int p = r.pages().begin(); p < r.pages().end(); p++)
+        for (int i = r.rows().begin(); i < r.rows().end(); i++)
+          for (int j = r.cols().begin(); j < r.cols().end(); j++) visits[(p * rows + i) * cols + j]++;
+    };
+    adapt::parallel_for(adapt::blocked_range3d<int>(0, pages, 2, 0, rows, 4, 0, cols, 8), body3d);
+    CHECK(std::count(visits.begin(), visits.begin() + rows * cols, 2) == rows * cols);
+    CHECK(std::count(visits.begin() + rows * cols, visits.end(), 1) == (pages - 1) * rows * cols);
+  }
+
+  SECTION("reductions over tiles") {
+    const long cells = adapt::parallel_reduce(
+      adapt::blocked_range2d<int>(0, 100, 7, 0, 30, 3), 0l,
+      [](const adapt::blocked_range2d<int> &r, long value) { return value + long(r.rows().size() * r.cols().size()); },
+      std::plus<long>());
+    CHECK(cells == 3000);
+  }
+}
+
+TEST_CASE("Parallel Algorithms") {
+  const int n = 100000;
+  std::vector<int> v(n);
+  std::iota(v.begin(), v.end(), 0);
+
+  SECTION("for_each and transform visit every element once") {
+    std::vector<long> out(n, 0);
+    CHECK(adapt::transform(v.begin(), v.end(), out.begin(), [](const int x) { return 2l * x; }) == out.end());
+    adapt::for_each(out.begin(), out.end(), [](long &x) { x += 1; });
+    bool odd = true;
+    for (int i = 0; i < n; i++) odd = odd && (out[i] == 2l * i + 1);
+    CHECK(odd);
+  }
+
+  SECTION("transform_reduce counts init once") {
+    auto widen = [](const int x) { return long(x); };
+    CHECK(adapt::transform_reduce(v.begin(), v.end(), 10l, std::plus<long>(), widen) == 10l + long(n) * (n - 1) / 2);
+    CHECK(adapt::transform_reduce(v.begin(), v.begin(), 10l, std::plus<long>(), widen) == 10l);
+  }
+
+  SECTION("count_if and find_if") {
+    CHECK(adapt::count_if(v.begin(), v.end(), [](const int x) { return x % 3 == 0; }) == (n + 2) / 3);
+    CHECK(adapt::find_if(v.begin(), v.end(), [](const int x) { return x >= 777 && x % 2 == 0; }) == v.begin() + 778);
+    CHECK(adapt::find_if(v.begin(), v.end(), [](const int x) { return x < 0; }) == v.end());
+    CHECK(adapt::find_if(v.begin(), v.end(), [](const int x) { return x % 1000 == 999; }) == v.begin() + 999);
+  }
+}
+
+TEST_CASE("Cancellation") {
+  const int n = 10000000;
+
+  SECTION("a cancelled loop stops extracting and stealing") {
+    adapt::cancellation_token token;
+    std::atomic<long> executed(0);
+    adapt::parallel_for(
+      0, n,
+      [&](const int b, const int e) {
+        executed += e - b;
+        token.cancel();
+      },
+      token);
+    CHECK(token.is_cancelled());
+    CHECK(executed < n / 2); // about one chunk per thread
+
+    token.reset();
+    executed = 0;
+    adapt::parallel_for(0, n, [&](const int b, const int e) { executed += e - b; }, token, adapt::default_policy());
+    CHECK(executed == n);
+  }
+
+  SECTION("a loop cancelled from a position stops extracting and stealing past it") {
+    adapt::cancellation_token token;
+    token.cancel_from(n / 2);
+    std::atomic<long> before(0), past(0);
+    adapt::parallel_for(
+      0, n,
+      [&](const int b, const int e) {
+        before += MIN(e, n / 2) - MIN(b, n / 2);
+        if (b >= n / 2) past++;
+      },
+      token);
+    CHECK_FALSE(token.is_cancelled());
+    CHECK(token.is_cancelled(n / 2));
+    CHECK(token.cancelled_from() == n / 2);
+    CHECK(before == n / 2); // every iteration before it
+    CHECK(past == 0);       // no chunk starting past it
+  }
+
+  SECTION("nested loops see the token") {
+    adapt::cancellation_token token;
+    std::atomic<long> executed(0);
+    adapt::parallel_for(0, 4, [&](const int, const int) {
+      adapt::parallel_for(
+        0, n,
+        [&](const int b, const int e) {
+          executed += e - b;
+          if (executed > n / 100) token.cancel();
+        },
+        token);
+    });
+    CHECK(executed < n);
+  }
+
+  SECTION("parallel_find, any_of, all_of and none_of") {
+    std::vector<int> v(n);
+    std::iota(v.begin(), v.end(), 0);
+    auto big = [](const int x) { return x >= 1000; };
+    std::vector<int>::iterator found = adapt::parallel_find(v.begin(), v.end(), big);
+    CHECK((found != v.end() && *found >= 1000));
+    CHECK(adapt::parallel_find(v.begin(), v.end(), [](const int x) { return x < 0; }) == v.end());
+    CHECK(adapt::parallel_find(v.begin(), v.begin(), big) == v.begin());
+    CHECK(adapt::any_of(v.begin(), v.end(), [n](const int x) { return x == n - 1; }));
+    CHECK_FALSE(adapt::any_of(v.begin(), v.end(), [n](const int x) { return x == n; }));
+    CHECK(adapt::all_of(v.begin(), v.end(), [](const int x) { return x >= 0; }));
+    CHECK_FALSE(adapt::all_of(v.begin(), v.end(), [](const int x) { return x != 5000000; }));
+    CHECK(adapt::none_of(v.begin(), v.end(), [](const int x) { return x < 0; }));
+  }
+}
+
+TEST_CASE("Parallel Scan") {
+  const int n = 200000;
+  std::vector<long> v(n), expected(n);
+  for (int i = 0; i < n; i++) v[i] = (i * 7919) % 1000;
+
+  SECTION("inclusive and exclusive scans") {
+    std::vector<long> out(n);
+    std::partial_sum(v.begin(), v.end(), expected.begin());
+    CHECK(adapt::inclusive_scan(v.begin(), v.end(), out.begin(), std::plus<long>()) == out.end());
+    CHECK(out == expected);
+
+    adapt::exclusive_scan(v.begin(), v.end(), out.begin(), 5l, std::plus<long>());
+    CHECK(out[0] == 5);
+    CHECK(std::equal(out.begin() + 1, out.end(), expected.begin(), [](long a, long b) { return a == b + 5; }));
+
+    out = v; // in place
+    adapt::inclusive_scan(out.begin(), out.end(), out.begin(), std::plus<long>());
+    CHECK(out == expected);
+  }
+
+  SECTION("operators need not be commutative") {
+    typedef std::pair<uint64_t, uint64_t> affine_t; // x -> a * x + b, composed left to right
+    auto compose = [](const affine_t &f, const affine_t &g) {
+      return affine_t(g.first * f.first, g.first * f.second + g.second);
+    };
+    std::vector<affine_t> maps(n), out(n), sequential(n);
+    for (int i = 0; i < n; i++) maps[i] = affine_t(2 * i + 1, i);
+    std::partial_sum(maps.begin(), maps.end(), sequential.begin(), compose);
+
+    typedef adapt::policy<adapt::default_victim, adapt::even_distribution> even_policy;
+    const affine_t total = adapt::parallel_scan(
+      0, n, affine_t(1, 0),
+      [&](const int b, const int e, affine_t prefix, const bool is_final) {
+        for (int i = b; i < e; i++) {
+          prefix = compose(prefix, maps[i]);
+          if (is_final) out[i] = prefix;
+        }
+        return prefix;
+      },
+      compose, even_policy());
+    CHECK(total == sequential.back());
+    CHECK(out == sequential);
+  }
+
+  SECTION("a single thread never pre-scans") {
+    adapt::task_arena arena(1);
+    size_t prescanned = 0;
+    arena.execute([&]() {
+      adapt::parallel_scan(
+        0, n, 0l,
+        [&](const int b, const int e, long prefix, const bool is_final) {
+          if (!is_final) prescanned += size_t(e - b);
+          for (int i = b; i < e; i++) prefix += v[i];
+          return prefix;
+        },
+        std::plus<long>());
+    });
+    CHECK(prescanned == 0);
+  }
+}
+
+TEST_CASE("Parallel Sort and Merge") {
+  const int n = 300000;
+  std::vector<int> v(n);
+  for (int i = 0; i < n; i++) v[i] = int((uint32_t(i) * 2654435761u) % 100000); // duplicates
+
+  SECTION("merge is stable") {
+    typedef std::pair<int, int> keyed_t; // (key, input)
+    std::vector<keyed_t> a(n / 3), b(n - n / 3), out(n), expected(n);
+    for (size_t i = 0; i < a.size(); i++) a[i] = keyed_t(v[i] % 1000, 0);
+    for (size_t i = 0; i < b.size(); i++) b[i] = keyed_t(v[a.size() + i] % 1000, 1);
+    auto by_key = [](const keyed_t &x, const keyed_t &y) { return x.first < y.first; };
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), expected.begin(), by_key);
+    CHECK(adapt::parallel_merge(a.begin(), a.end(), b.begin(), b.end(), out.begin(), by_key) == out.end());
+    CHECK(out == expected);
+  }
+
+  SECTION("sort") {
+    std::vector<int> expected(v);
+    std::sort(expected.begin(), expected.end());
+    adapt::parallel_sort(v.begin(), v.end());
+    CHECK(v == expected);
+
+    adapt::parallel_sort(v.begin(), v.end(), std::greater<int>());
+    CHECK(std::is_sorted(v.begin(), v.end(), std::greater<int>()));
+
+    std::vector<int> small(v.begin(), v.begin() + 100);
+    adapt::parallel_sort(small.begin(), small.end());
+    CHECK(std::is_sorted(small.begin(), small.end()));
+  }
+}
+
+TEST_CASE("Deterministic Reductions") {
+  const int n = 1000003;
+  std::vector<double> v(n);
+  for (int i = 0; i < n; i++) v[i] = ((i * 7919L) % 1000 - 500) * std::pow(10.0, (i % 17) - 8); // rounding matters
+  auto sum = [&v](const int b, const int e, double value) {
+    for (int i = b; i < e; i++) value += v[i];
+    return value;
+  };
+
+  SECTION("same bits on any number of threads and policy") {
+    const double global = adapt::parallel_deterministic_reduce(0, n, 0.0, sum, std::plus<double>());
+    typedef adapt::policy<adapt::default_victim, adapt::demand_distribution> demand_policy;
+    CHECK(adapt::parallel_deterministic_reduce(0, n, 0.0, sum, std::plus<double>(), demand_policy()) == global);
+    auto reduce = [&]() { return adapt::parallel_deterministic_reduce(0, n, 0.0, sum, std::plus<double>()); };
+    for (size_t threads = 1; threads <= 3; threads++) {
+      adapt::task_arena arena(threads);
+      CHECK(arena.execute(reduce) == global);
+    }
+  }
+
+  SECTION("blocks are combined in index order") {
+    const size_t block = 1000;
+    double expected    = 0.0;
+    for (int b = 0; b < n; b += int(block)) expected += sum(b, std::min(n, b + int(block)), 0.0);
+    CHECK(adapt::parallel_deterministic_reduce(0, n, 0.0, sum, std::plus<double>(), adapt::default_policy(), block) ==
+          expected);
+  }
+}
+
+struct counted_histogram { // counts its copies
+  static std::atomic<int> copies;
+  std::vector<long> bins;
+
+  counted_histogram(const size_t size = 0) : bins(size, 0) {}
+  counted_histogram(const counted_histogram &other) : bins(other.bins) { copies++; }
+  counted_histogram(counted_histogram &&other) = default;
+  counted_histogram &operator=(const counted_histogram &other) {
+    copies++;
+    bins = other.bins;
+    return *this;
+  }
+  counted_histogram &operator=(counted_histogram &&other) = default;
+};
+std::atomic<int> counted_histogram::copies(0);
+
+TEST_CASE("In-place Reductions") {
+  const int n = 100000, bins = 64;
+  auto fill = [](const int b, const int e, counted_histogram &h) {
+    for (int i = b; i < e; i++) h.bins[(i * 31) % bins]++;
+  };
+  auto merge = [](counted_histogram &left, counted_histogram &&right) {
+    for (size_t i = 0; i < left.bins.size(); i++) left.bins[i] += right.bins[i];
+  };
+  auto complete = [&](const counted_histogram &h) {
+    return std::accumulate(h.bins.begin(), h.bins.end(), 0l) == n &&
+           *std::min_element(h.bins.begin(), h.bins.end()) == n / bins;
+  };
+
+  SECTION("values are copied once per thread only") {
+    counted_histogram::copies = 0;
+    const counted_histogram h = adapt::parallel_reduce(0, n, counted_histogram(bins), fill, merge);
+    CHECK(complete(h));
+    CHECK(counted_histogram::copies <= int(adapt::get_num_threads()));
+  }
+
+  SECTION("in-place bodies with returning reductions, nested and deterministic") {
+    auto add = [](counted_histogram left, const counted_histogram &right) {
+      for (size_t i = 0; i < left.bins.size(); i++) left.bins[i] += right.bins[i];
+      return left;
+    };
+    CHECK(complete(adapt::parallel_reduce(0, n, counted_histogram(bins), fill, add)));
+    CHECK(complete(adapt::parallel_deterministic_reduce(0, n, counted_histogram(bins), fill, merge)));
+
+    std::atomic<int> nested(0);
+    adapt::parallel_for(0, 4, [&](const int b, const int e) {
+      for (int i = b; i < e; i++)
+        nested += complete(adapt::parallel_reduce(0, n, counted_histogram(bins), fill, merge));
+    });
+    CHECK(nested == 4);
+  }
+
+  SECTION("returning reductions taking the left value by reference") {
+    auto sum = [](const int b, const int e, long &value) {
+      for (int i = b; i < e; i++) value += i;
+    };
+    auto add         = [](long &left, const long &right) { return left + right; };
+    const long total = adapt::parallel_reduce(0, n, 0l, sum, add);
+    CHECK(total == long(n) * (n - 1) / 2);
+  }
+
+  SECTION("returning reductions taking both values by reference") {
+    auto sum = [](const int b, const int e, long &value) {
+      for (int i = b; i < e; i++) value += i;
+    };
+    auto add         = [](long &left, long &right) { return left + right; };
+    const long total = adapt::parallel_reduce(0, n, 0l, sum, add);
+    CHECK(total == long(n) * (n - 1) / 2);
+  }
+}
+
+TEST_CASE("Thread Specific Storage") {
+  const int n           = 100000;
+  const int num_threads = int(adapt::get_num_threads());
+
+  SECTION("worker ids") {
+    CHECK(adapt::this_worker_id() == -1);
+    std::atomic<int> out_of_range(0);
+    adapt::parallel_for(0, n, [&](const int, const int) {
+      const int id = adapt::this_worker_id();
+      if (id < 0 || id >= num_threads) out_of_range++;
+    });
+    CHECK(out_of_range == 0);
+  }
+
+  SECTION("values are created once per worker and combined") {
+    adapt::enumerable_thread_specific<std::vector<long>> partial(std::vector<long>(4, 0));
+    std::atomic<int> created(0);
+    for (int rep = 0; rep < 3; rep++)
+      adapt::parallel_for(0, n, [&](const int b, const int e) {
+        bool exists;
+        std::vector<long> &local = partial.local(exists);
+        if (!exists) created++;
+        for (int i = b; i < e; i++) local[i % 4] += i;
+      });
+    CHECK(created <= num_threads);
+    CHECK(partial.size() == size_t(created));
+
+    long each = 0;
+    partial.combine_each([&each](const std::vector<long> &v) { each += v[0] + v[1] + v[2] + v[3]; });
+    const std::vector<long> total = partial.combine([](std::vector<long> &left, std::vector<long> &&right) {
+      for (size_t i = 0; i < left.size(); i++) left[i] += right[i];
+    });
+    CHECK(each == 3l * n * (n - 1) / 2);
+    CHECK(total[0] + total[1] + total[2] + total[3] == each);
+    CHECK(partial.empty());
+  }
+}
+
+static long task_fib(const int n) {
+  if (n < 12) return (n < 2) ? n : task_fib(n - 1) + task_fib(n - 2);
+  long a, b;
+  adapt::task_group group;
+  group.run([&a, n]() { a = task_fib(n - 1); });
+  b = task_fib(n - 2);
+  group.wait();
+  return a + b;
+}
+
+TEST_CASE("Task Groups") {
+  SECTION("recursive tasks") {
+    CHECK(task_fib(24) == 46368);
+    adapt::task_arena arena(2);
+    CHECK(arena.execute([]() { return task_fib(20); }) == 6765);
+  }
+
+  SECTION("tasks run from loop bodies and from other tasks") {
+    const int n = 64, leaves = 16;
+    std::vector<std::atomic<int>> visits(n * leaves);
+    for (auto &v : visits) v = 0;
+    std::atomic<int> unfinished(0); // groups whose tasks were not over after wait, checked on this thread
+    adapt::parallel_for(0, n, [&](const int b, const int e) {
+      for (int i = b; i < e; i++) {
+        adapt::task_group group;
+        for (int l = 0; l < leaves; l += 2)
+          group.run([&visits, &group, i, l, leaves]() {
+            visits[i * leaves + l]++;
+            group.run([&visits, i, l, leaves]() { visits[i * leaves + l + 1]++; });
+          });
+        group.wait();
+        if (visits[i * leaves + leaves - 1] != 1) unfinished++;
+      }
+    });
+    CHECK(unfinished == 0);
+    CHECK(std::count(visits.begin(), visits.end(), 1) == n * leaves);
+  }
+
+  SECTION("parallel_invoke") {
+    std::vector<int> calls(3, 0);
+    adapt::parallel_invoke([&]() { calls[0]++; }, [&]() { calls[1]++; }, [&]() { calls[2]++; });
+    CHECK(calls == std::vector<int>(3, 1));
+
+    const long halves = adapt::parallel_reduce(
+      0, 8, 0l,
+      [](const int b, const int e, long value) {
+        for (int i = b; i < e; i++) {
+          long left, right;
+          adapt::parallel_invoke([&left]() { left = task_fib(15); }, [&right]() { right = task_fib(14); });
+          value += left + right;
+        }
+        return value;
+      },
+      std::plus<long>());
+    CHECK(halves == 8 * 987);
+  }
+}
+
+TEST_CASE("Asynchronous Loops") {
+  const int n = 100000;
+
+  SECTION("the loop runs while the launching thread goes on") {
+    std::vector<std::atomic<int>> visits(n);
+    for (auto &v : visits) v = 0;
+    adapt::loop_handle loop = adapt::parallel_for_async(0, n, [&visits](const int b, const int e) {
+      for (int i = b; i < e; i++) visits[i]++;
+    });
+    long serial = 0;
+    for (int i = 0; i < n; i++) serial += i; // overlapped work
+    if (adapt::get_num_threads() > 1)
+      while (!loop.ready()) std::this_thread::yield(); // pool threads take the share of this one
+    loop.wait();
+    CHECK(loop.ready());
+    CHECK(serial == long(n) * (n - 1) / 2);
+    CHECK(std::count(visits.begin(), visits.end(), 1) == n);
+  }
+
+  SECTION("handles are moved and waited for on destruction") {
+    std::vector<int> v(n, 0);
+    for (int rep = 0; rep < 10; rep++) {
+      adapt::loop_handle loop;
+      loop = adapt::parallel_for_async(0, n, [&v](const int b, const int e) {
+        for (int i = b; i < e; i++) v[i]++;
+      });
+    }
+    adapt::parallel_for(0, n, [&v](const int b, const int e) {
+      for (int i = b; i < e; i++) v[i]++;
+    });
+    CHECK(std::count(v.begin(), v.end(), 11) == n);
+  }
+
+  SECTION("nested in a running loop") {
+    std::atomic<long> sum(0);
+    std::atomic<int> pending(0); // nested loops not over on return, checked on this thread
+    adapt::parallel_for(0, 8, [&sum, &pending, n](const int b, const int e) {
+      for (int i = b; i < e; i++) {
+        adapt::loop_handle loop = adapt::parallel_for_async(0, n, [&sum](const int cb, const int ce) {
+          long local = 0;
+          for (int c = cb; c < ce; c++) local += c;
+          sum += local;
+        });
+        if (!loop.ready()) pending++;
+      }
+    });
+    CHECK(pending == 0);
+    CHECK(sum == 8l * n * (n - 1) / 2);
+  }
+
+  SECTION("loops of the launching thread nest in its asynchronous loop") {
+    std::vector<std::atomic<int>> visits(n);
+    for (auto &v : visits) v = 0;
+    adapt::loop_handle loop = adapt::parallel_for_async(0, n, [&visits](const int b, const int e) {
+      for (int i = b; i < e; i++) visits[i]++;
+    });
+    adapt::parallel_for(0, n, [&visits](const int b, const int e) {
+      for (int i = b; i < e; i++) visits[i]++;
+    });
+    const long sum = adapt::parallel_reduce(
+      0, n, 0l,
+      [](const int b, const int e, long value) {
+        for (int i = b; i < e; i++) value += i;
+        return value;
+      },
+      std::plus<long>());
+    adapt::task_group group;
+    group.run([&visits]() { visits[0]++; });
+    group.wait();
+    adapt::loop_handle again = adapt::parallel_for_async(0, n, [&visits](const int b, const int e) {
+      for (int i = b; i < e; i++) visits[i]++;
+    });
+    CHECK(again.ready());
+    loop.wait();
+    CHECK(sum == long(n) * (n - 1) / 2);
+    CHECK(visits[0] == 4);
+    CHECK(std::count(visits.begin(), visits.end(), 3) == n - 1);
+  }
+}
+
+TEST_CASE("Packed Sub-ranges") {
+  using namespace adapt::__internal__;
+
+  SECTION("indices up to 32 bits are packed") {
+    CHECK(uses_packed_range<int>::value);
+    CHECK(uses_packed_range<unsigned short>::value);
+    CHECK_FALSE(uses_packed_range<long long>::value);
+  }
+
+  SECTION("bounds survive packing") {
+    const uint64_t word = PackedRange<int>::pack(-7, 1 << 30);
+    CHECK(PackedRange<int>::first_of(word) == -7);
+    CHECK(PackedRange<int>::last_of(word) == 1 << 30);
+  }
+
+  SECTION("first and last read the packed word") {
+    typedef adapt::policy<adapt::default_victim, adapt::demand_distribution> policy_t;
+    ForWorker<int, for_body, policy_t> worker(0, 0, 100, nullptr, for_compute, policy_t());
+    CHECK(worker.first == 0);
+    CHECK(worker.last == 100);
+    worker.range.word = PackedRange<int>::pack(10, 20);
+    CHECK(worker.first == 10);
+    CHECK(worker.last == 20);
+  }
+}
+
+TEST_CASE("Core Classification") {
+  using adapt::__internal__::Topology;
+  std::vector<bool> little;
+
+  SECTION("symmetric cores") {
+    CHECK(Topology::classify({1024, 1024, 1024, 1024}, little) == 1);
+    CHECK(std::count(little.begin(), little.end(), true) == 0);
+  }
+
+  SECTION("favored cores with higher turbo are not big.LITTLE") {
+    CHECK(Topology::classify({4800000, 4600000, 4600000, 4600000}, little) == 1);
+    CHECK(std::count(little.begin(), little.end(), true) == 0);
+  }
+
+  SECTION("big.LITTLE capacities") { // Jetson TX2 like: 2 big, 4 LITTLE
+    CHECK(Topology::classify({446, 1024, 1024, 446, 446, 446}, little) == 2);
+    CHECK(little == std::vector<bool>({true, false, false, true, true, true}));
+  }
+
+  SECTION("unknown capacities") {
+    CHECK(Topology::classify({0, 0}, little) == 1);
+    CHECK(std::count(little.begin(), little.end(), true) == 0);
+  }
+}